@@ -1,11 +1,114 @@
 #pragma once
 #include <Arduino.h>
 #include <driver/i2s.h>
+#include <atomic>
 #include "config.h"
+#include "SpscQueue.h"
+#include "Oscillator.h"
 
 // Audio Defaults
 // SAMPLE_RATE defined in config.h
 #define NUM_CHANNELS 2 // Output stereo (duplicated mono) usually works best with generic I2S amps
+#define AUDIO_CHUNK_SAMPLES 128 // Frames rendered per i2s_write in the default profile (approx 3ms)
+#define AUDIO_MAX_CHUNK_SAMPLES 256 // Largest chunk of any profile (sizes the render buffers)
+#define AUDIO_CMD_LANES 4        // One SPSC lane per producing task (plus a shared lane for the rest)
+#define AUDIO_CMD_QUEUE_LEN 32   // Commands per lane (power of 2)
+#define AUDIO_CMD_PER_CHUNK 16   // Max commands applied within one chunk
+#define AUDIO_MAX_VOICES 8       // Overlapping clicks before voice stealing
+#define AUDIO_BLOCKED_WRITE_US 100 // i2s_write slower than this waited for a free DMA buffer
+#define AUDIO_EMISSION_RING 8    // Recent clicks kept for the mic path (power of 2)
+
+enum ClickType : uint8_t {
+    CLICK_NORMAL,
+    CLICK_ACCENT,
+    CLICK_SUB,
+    CLICK_CHIRP, // Falling sweep for latency calibration, not a beat sound
+    CLICK_TYPES
+};
+
+// Output latency/efficiency profiles, switchable at runtime
+enum AudioProfileId : uint8_t {
+    AUDIO_PROFILE_LOW_LATENCY,
+    AUDIO_PROFILE_BALANCED,
+    AUDIO_PROFILE_BATTERY,
+    AUDIO_PROFILE_COUNT
+};
+
+struct AudioProfile {
+    const char* name;
+    uint32_t sampleRate;
+    uint16_t dmaBufCount;
+    uint16_t dmaBufLen;    // Frames per DMA buffer
+    uint16_t chunkSamples; // Frames rendered per i2s_write
+};
+
+extern const AudioProfile kAudioProfiles[AUDIO_PROFILE_COUNT];
+
+// Pre-rendered click at unity gain (Q15 mono)
+struct ClickSample {
+    int16_t* data = nullptr;
+    uint32_t length = 0;
+};
+
+// One playing click; the pool is statically allocated inside AudioEngine
+struct ClickVoice {
+    const int16_t* data;
+    uint32_t length;
+    uint32_t pos;
+    int32_t gain; // Q15
+};
+
+enum AudioCommandType : uint8_t {
+    CMD_CLICK,
+    CMD_TONE_ON,   // value = frequency in Hz (also retunes a running tone)
+    CMD_TONE_OFF,
+    CMD_VOLUME     // value = 0-100
+};
+
+// Timestamped command for the audio task
+struct AudioCommand {
+    uint64_t at;           // Output sample index to execute at (0 = as soon as possible)
+    AudioCommandType type;
+    ClickType click;       // CMD_CLICK only
+    float value;           // Click gain / tone frequency / volume
+};
+
+// Beat produced by the sample-accurate scheduler inside the audio task
+struct BeatEvent {
+    uint64_t sample;   // Output sample index at which the click starts
+    int64_t heardUs;   // esp_timer time at which that sample reaches the DAC
+    uint8_t beat;      // Beat within the bar (0 = downbeat)
+    bool accent;
+};
+
+// A click as it leaves the speaker, so input paths can ignore their own output.
+// The envelope is exactly that of the cached waveform: level * exp(-t / decayUs).
+struct ClickEmission {
+    ClickType type;
+    int64_t heardUs;   // esp_timer time at which the first sample reaches the DAC
+    uint32_t lengthUs; // Until the tail is below -80 dB
+    uint32_t decayUs;  // Envelope time constant
+    float level;       // Peak output amplitude, 0..1 of full scale (gain and volume applied)
+};
+
+// Snapshot of the output clock. Sample S is heard at
+// epochUs + (S - epochSample) / rate; the epoch is re-measured from the
+// moments i2s_write has to wait for the DMA ring.
+struct AudioClock {
+    uint64_t submitted;   // Samples handed to i2s_write so far
+    uint64_t epochSample;
+    int64_t epochUs;      // esp_timer_get_time() at which epochSample is heard
+    uint32_t rate;
+    uint64_t lastBeat;    // Start sample of the latest scheduled beat (0 = none)
+    uint64_t nextBeat;    // Start sample of the following beat (0 = stopped)
+
+    int64_t sampleToMicros(uint64_t sample) const {
+        return epochUs + (int64_t)(sample - epochSample) * 1000000LL / (int64_t)rate;
+    }
+    uint64_t microsToSample(int64_t us) const {
+        return epochSample + (uint64_t)((us - epochUs) * (int64_t)rate / 1000000LL);
+    }
+};
 
 class AudioEngine {
 public:
@@ -16,6 +119,33 @@ public:
     // isAccent: true = Higher Pitch (Downbeat/One), false = Lower Pitch
     // isSubdivision: true = Very soft tick for subdivision
     void playClick(bool isAccent, bool isSubdivision = false);
+
+    // Queue a click at an exact output sample (see getSampleClock); false if
+    // the queue is full. Commands from one task are applied in the order
+    // they were sent, so a click timed in the future holds back everything
+    // the same task queues after it (volume, tone) until it is due.
+    bool scheduleClick(ClickType type, float gain, uint64_t atSample = 0);
+
+    // Samples submitted to I2S so far (safe from any task)
+    uint64_t getSampleClock() const;
+
+    // --- Output clock (safe from any task) ---
+    // Conversions use the current profile's rate, so samples from before a
+    // profile switch map only approximately.
+    AudioClock getClock() const;
+    int64_t sampleToMicros(uint64_t sample) const { return getClock().sampleToMicros(sample); }
+    uint64_t microsToSample(int64_t us) const { return getClock().microsToSample(us); }
+    uint64_t getPlayheadSample() const; // Sample at the DAC right now
+    int64_t getNextBeatMicros() const;  // When the next beat is heard (0 = stopped)
+
+    // Latest clicks started by the audio task, newest first (safe from any
+    // task, lock-free); returns how many were copied
+    size_t getRecentClicks(ClickEmission* out, size_t max) const;
+
+    // The click waveform as the current profile plays it (same duration and
+    // sweep), rendered at another rate, e.g. as a reference for the mic.
+    // Returns the number of samples written (at unity gain, Q15).
+    uint32_t renderClick(ClickType type, uint32_t sampleRate, int16_t* dst, uint32_t maxLength) const;
     
     // Play a continuous tone (signals the audio task)
     void startTone(float frequency);
@@ -29,8 +159,48 @@ public:
     // Overdrive flag (set when limiter clamps); returns and clears flag
     bool wasOverdriven();
 
-    // Optional beat callback (for haptics)
-    void setBeatCallback(void (*cb)(bool accent)) { _beatCallback = cb; }
+    // Commands lost to full queues since boot
+    uint32_t getDroppedCommands() const { return _droppedCommands.load(std::memory_order_relaxed); }
+
+    // --- Metronome (beat clock owned by the audio task) ---
+    // Parameters are read by the audio task at the next beat, so they can be
+    // changed while running without restarting the bar.
+    void setTempo(float bpm); // Fractional BPM, e.g. 97.5
+    float getTempo() const { return _tempoNow; } // Includes ramp progress
+    void setBeatsPerBar(int beats);
+    void setSubdivision(int clicksPerBeat); // 1 = quarters only, 2..4 = subdivided
+    void startMetronome();   // Restarts at beat 0 of a new bar
+    void stopMetronome();
+    bool isMetronomeRunning() const { return _metroRunning; }
+
+    // Continuous accelerando/ritardando: tempo moves by bpmPerBeat on every
+    // beat until targetBpm is reached (direction follows the sign of the gap).
+    void setTempoRamp(float targetBpm, float bpmPerBeat);
+    void clearTempoRamp() { _rampActive = false; }
+    bool isTempoRamping() const { return _rampActive; }
+
+    // Pop the next scheduled beat (rendered, not yet audible); false on timeout
+    bool getBeatEvent(BeatEvent& evt, TickType_t wait);
+
+    // --- Output profile ---
+    // Applied by the audio task at the next chunk (I2S driver is reinstalled,
+    // clicks re-rendered, running beat grid rescaled to the new rate).
+    void setProfile(AudioProfileId id);
+    AudioProfileId getProfile() const { return _requestedProfile; }
+    uint32_t getSampleRate() const { return _sampleRate; }
+
+    // Time from rendering a sample to it leaving the DMA ring (worst case)
+    uint32_t getOutputLatencySamples() const { return _latencySamples; }
+    uint32_t getOutputLatencyUs() const;
+
+#ifdef AUDIO_BENCHMARK
+    // Average CPU cycles spent rendering one chunk (excludes i2s_write)
+    uint32_t getRenderCycles() const { return _renderCycles; }
+#endif
+
+    // Optional callback for manual clicks (haptics/LED); heardUs is when the
+    // click reaches the speaker, in esp_timer time
+    void setBeatCallback(void (*cb)(bool accent, int64_t heardUs)) { _beatCallback = cb; }
 
 private:
     static void taskEntry(void* param);
@@ -38,22 +208,106 @@ private:
     TaskHandle_t _audioTaskHandle = NULL;
 
     volatile uint8_t _volume = 50; // 0-100
+
+    // Output profile (requested by UI, applied by the task)
+    volatile AudioProfileId _requestedProfile = AUDIO_PROFILE_BALANCED;
+    AudioProfileId _activeProfile = AUDIO_PROFILE_BALANCED;
+    volatile uint32_t _sampleRate = SAMPLE_RATE;
+    volatile uint32_t _latencySamples = 0;
+    void installDriver(const AudioProfile& profile);
+    void applyProfile(AudioProfileId id);
     
-    // Tone generation state (Shared)
-    volatile bool _isTonePlaying = false;
-    volatile float _toneFreq = 440.0f;
-    
-    // Click Trigger (Shared)
-    volatile bool _triggerClick = false;
-    volatile bool _triggerClickAccent = false;
-    volatile bool _triggerClickSub = false;
+    // Command lanes (Shared). Each producing task claims its own SPSC lane on
+    // first use, so every command is delivered without locks on the audio path.
+    // Lanes are never given back (a deleted task's handle can't be told from
+    // a live one); tasks beyond AUDIO_CMD_LANES, or recreated ones, share the
+    // last lane, whose producers take turns under _sharedLaneLock.
+    struct CommandLane {
+        std::atomic<TaskHandle_t> owner{NULL};
+        SpscQueue<AudioCommand, AUDIO_CMD_QUEUE_LEN> queue;
+    };
+    CommandLane _lanes[AUDIO_CMD_LANES + 1];
+    portMUX_TYPE _sharedLaneLock = portMUX_INITIALIZER_UNLOCKED;
+    std::atomic<uint32_t> _droppedCommands{0};
+    // Queued in FIFO order per task: a command is applied once it is due and
+    // everything sent before it by the same task has been applied
+    bool sendCommand(const AudioCommand& cmd);
+    int collectCommands(uint64_t chunkEnd, AudioCommand* due);
+    void applyCommand(const AudioCommand& cmd, uint64_t atSample);
+
+    // Click emissions (written by the task, read by anyone). An entry is
+    // valid while fewer than AUDIO_EMISSION_RING newer ones were published.
+    ClickEmission _emissions[AUDIO_EMISSION_RING];
+    std::atomic<uint32_t> _emitted{0};
+    void recordEmission(ClickType type, float gain, uint64_t atSample);
+
+    // Published output clock (seqlock: odd sequence = update in progress)
+    std::atomic<uint32_t> _clockSeq{0};
+    AudioClock _clockPublished = {};
+
+    // Metronome parameters (Shared)
+    volatile float _bpm = 120.0f;      // Last tempo requested by the UI
+    volatile float _tempoNow = 120.0f; // Tempo of the beat being played
+    volatile bool _rampActive = false;
+    volatile float _rampTarget = 120.0f;
+    volatile float _rampPerBeat = 0.0f;
+    volatile int _beatsPerBar = 4;
+    volatile int _clicksPerBeat = 1;
+    volatile bool _metroRunning = false;
+    volatile bool _metroRestart = false;
+    QueueHandle_t _beatQueue = NULL;
 
     // Internal synthesis state (Task only)
-    float _tonePhase = 0;
+    uint8_t _mixVolume = 50;
+    bool _toneOn = false;
+    float _toneHz = 440.0f;
+    Oscillator _toneOsc;
+    ClickSample _clickCache[CLICK_TYPES];
+    ClickVoice _voices[AUDIO_MAX_VOICES]; // [0, _activeVoices) are playing
+    int _activeVoices = 0;
+    int32_t _mixBuf[AUDIO_MAX_CHUNK_SAMPLES];  // Mix bus (Q15 headroom in int32)
+    int16_t _monoBuf[AUDIO_MAX_CHUNK_SAMPLES]; // After limiter
+    int32_t _gainQ31 = 0;                  // Smoothed master gain
+
+    // Beat scheduler state (Task only)
+    uint64_t _sampleClock = 0;     // Samples rendered so far
+    bool _schedActive = false;
+    // Positions are Q32.32 sample times split into whole + fraction so the
+    // beat grid never accumulates rounding error.
+    float _schedBpm = 120.0f;      // Tempo driving the scheduler
+    float _lastUiBpm = 120.0f;
+    uint64_t _beatStart = 0;       // Sample index of the current beat
+    uint32_t _beatStartFrac = 0;
+    uint64_t _beatLenQ32 = 0;      // Samples per beat (Q32.32), latched at each beat
+    uint64_t _nextEvent = 0;       // Sample index of the next click
+    uint32_t _nextEventFrac = 0;
+    int _clickIndex = 0;           // Click within the current beat
+    int _clicksThisBeat = 1;
+    int _beatIndex = 0;
+
+    // Output clock estimate (Task only)
+    uint64_t _epochSample = 0;
+    int64_t _epochUs = 0;
+    bool _epochLocked = false;     // False until a blocking write has measured the ring
     
     // Reporting
     volatile bool _overdrive = false;
+#ifdef AUDIO_BENCHMARK
+    volatile uint32_t _renderCycles = 0;
+#endif
+
+    void (*_beatCallback)(bool accent, int64_t heardUs) = nullptr;
+    void renderClickCache();
+    void startClick(ClickType type, float gain, uint64_t atSample);
+    void fireScheduledClick();
+    template <bool kTone, bool kClicks> void renderKernel(size_t from, size_t to);
+    void generateVoices(size_t from, size_t to);
+    void resetEpoch();
+    void submitChunk(const uint32_t* frames, size_t chunkSamples);
+    void publishClock();
 
-    void (*_beatCallback)(bool accent) = nullptr;
-    int16_t applyLimiter(int32_t sample);
+    // Idle handling: the audio task parks (I2S TX stopped) when nothing is pending
+    std::atomic<bool> _idle{false};
+    void wakeIfIdle();
+    bool hasPendingWork() const;
 };
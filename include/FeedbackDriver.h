@@ -0,0 +1,42 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "LedRing.h"
+#include "config.h"
+
+#define FEEDBACK_QUEUE_LEN 8
+
+// One haptic/LED pulse, timed against esp_timer_get_time()
+struct FeedbackPulse {
+    int64_t startUs;     // When the pulse should begin (e.g. when the click is heard)
+    uint32_t durationUs;
+    uint16_t duty;       // Haptic 10-bit duty (0 = no vibration)
+    uint8_t ledFrame;    // LedRing frame to show (LED_FRAME_NONE = LED stays off)
+};
+
+// Plays scheduled pulses from its own task. On/off edges come from
+// esp_timer one-shots, so neither pulse start nor length depends on how
+// often the UI loop runs.
+class FeedbackDriver {
+public:
+    void begin(LedRing* ring);
+
+    // Queue a pulse (safe from any task); false if the queue is full.
+    // Pulses are played in order; one that is already due starts at once.
+    bool schedule(const FeedbackPulse& pulse);
+
+private:
+    static void taskEntry(void* param);
+    void feedbackLoop();
+    static void onTimerCb(void* param);
+    static void offTimerCb(void* param);
+    void pulseOn();
+    void pulseOff();
+
+    LedRing* _ring = nullptr;
+    QueueHandle_t _queue = NULL;
+    TaskHandle_t _taskHandle = NULL;
+    esp_timer_handle_t _onTimer = NULL;
+    esp_timer_handle_t _offTimer = NULL;
+    FeedbackPulse _current = {}; // Written by the task only while no timer is armed
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include "PitchEngine.h"
+#include "RealFFT.h"
+
+#define FFT_SAMPLES 256 // Power of 2
+#define FFT_ZOOM_POINTS 16 // Chirp-z evaluation points around the coarse peak
+#define FFT_ZOOM_SPAN 2.0f // Width of the zoomed band in FFT bins (coarse peak +-1 bin)
+
+// Strongest spectral peak of a Hamming-windowed frame, in two stages: the
+// FFT (15.6 Hz bins at 4 kHz) finds the peak bin, then a chirp-z
+// transform evaluates the spectrum on a 16-point grid spanning +-1 bin
+// around it (~2 Hz spacing) and interpolates between those. Resolution
+// improves ~8x without a longer window, i.e. without more latency.
+class FftPitchEngine : public PitchEngine {
+public:
+    void begin() { _fft.begin(); }
+    const char* name() const override { return "FFT"; }
+    int frameSize() const override { return FFT_SAMPLES; }
+    float detect(float* frame, float sampleRate) override;
+
+private:
+    RealFFT<FFT_SAMPLES> _fft;
+    float _windowed[FFT_SAMPLES]; // Time-domain frame for the zoom (the FFT works in place)
+    float zoom(float coarse, float sampleRate) const;
+};
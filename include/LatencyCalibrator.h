@@ -0,0 +1,93 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "AudioEngine.h"
+#include "MicStream.h"
+
+#define CALIB_BURSTS 5            // Chirps per calibration
+#define CALIB_MIN_GOOD 3          // Bursts that must correlate for a result
+#define CALIB_SETTLE_MS 250       // Mic settles after resume before the first chirp
+#define CALIB_GAP_MS 300          // Chirp + room decay between bursts
+#define CALIB_TIMEOUT_MS 1000     // A chirp that never shows up on the output fails the run
+#define CALIB_PRE_US 5000         // Search starts this long before the chirp reaches the DAC
+#define CALIB_MAX_LATENCY_US 60000 // ...and ends this long after it
+#define CALIB_REF_SAMPLES 512     // Reference chirp at the mic rate (32 ms, the loud part)
+#define CALIB_SEARCH_SAMPLES ((CALIB_PRE_US + CALIB_MAX_LATENCY_US) * (MIC_SAMPLE_RATE / 1000) / 1000)
+#define CALIB_MIN_CORR 0.3f       // Normalised correlation a burst needs to count
+#define CALIB_LAGS_PER_UPDATE 64  // Correlation lags per update() call, so the UI keeps running
+
+enum CalibrationState : uint8_t {
+    CALIB_IDLE,
+    CALIB_RUNNING,
+    CALIB_DONE,
+    CALIB_FAILED
+};
+
+// Measures the loopback latency from the DAC to the mic timestamps: plays
+// a known chirp through the audio engine, finds it in the capture ring by
+// normalised cross-correlation against the same waveform rendered at the
+// mic rate, and takes the median over several bursts. The result is the
+// offset between AudioEngine "heard" times and MicStream sample times for
+// sound from our own speaker (amp, speaker, air and mic path together).
+//
+// Driven from the UI loop; the mic must be running (see MicStream::resume).
+// The capture buffers (~12 KB) are on the heap only while a run is in
+// progress, and each update() call correlates a slice of the lags.
+class LatencyCalibrator {
+public:
+    void begin(AudioEngine* audio, MicStream* mic); // Renders the reference
+
+    void start();
+    void cancel();
+
+    // Call regularly while running; true once when a new result is ready
+    bool update();
+
+    CalibrationState getState() const { return _state; }
+    int getBurst() const { return _burst; }      // Bursts played so far
+    int getGoodBursts() const { return _good; }
+    int32_t getLatencyUs() const { return _latencyUs; }
+    const char* getError() const { return _error; }
+
+private:
+    enum Phase : uint8_t { PHASE_WAIT, PHASE_PLAY, PHASE_WAIT_OUTPUT, PHASE_WAIT_CAPTURE, PHASE_ANALYZE };
+
+    void fail(const char* error);
+    void finish();
+    void release();
+    void nextBurst(unsigned long now);
+    uint32_t micIndexAt(int64_t us) const;
+    void prepare();
+    bool scan();
+    bool measure(int32_t& latencyUs) const;
+    float correlate(uint32_t lag) const;
+
+    AudioEngine* _audio = nullptr;
+    MicStream* _mic = nullptr;
+
+    CalibrationState _state = CALIB_IDLE;
+    Phase _phase = PHASE_WAIT;
+    unsigned long _phaseStart = 0;
+    unsigned long _waitMs = 0;
+    int64_t _sentUs = 0;
+    int64_t _heardUs = 0;    // When the current chirp reaches the DAC
+    uint32_t _captureFrom = 0;
+    int _burst = 0;
+    int _good = 0;
+    int32_t _results[CALIB_BURSTS];
+    int32_t _latencyUs = 0;
+    const char* _error = "";
+
+    int16_t _ref[CALIB_REF_SAMPLES];
+    float _refEnergy = 0.0f;
+
+    // Allocated for the duration of a run
+    int32_t* _capture = nullptr; // CALIB_SEARCH_SAMPLES + CALIB_REF_SAMPLES
+    float* _signal = nullptr;    // Same length, zero-mean float copy
+
+    // Correlation progress of the current burst
+    uint32_t _lag = 0;
+    float _energy = 0.0f;  // Of the capture window under the reference at _lag
+    float _best = 0.0f;
+    uint32_t _bestLag = 0;
+};
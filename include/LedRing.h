@@ -0,0 +1,48 @@
+#pragma once
+#include <Arduino.h>
+#include <driver/rmt.h>
+#include <atomic>
+#include "config.h"
+
+#define LED_MAX_BEATS 16
+#define LED_FRAME_BYTES (WS2812_NUM_LEDS * 3) // GRB wire order
+
+// Precomputed frames. Beat frames follow LED_FRAME_BEAT0 (beat k = BEAT0 + k).
+enum LedFrameId : uint8_t {
+    LED_FRAME_OFF,
+    LED_FRAME_FLASH_ACCENT, // Whole ring, accent color (manual clicks)
+    LED_FRAME_FLASH,        // Whole ring, beat color
+    LED_FRAME_BEAT0,
+    LED_FRAME_COUNT = LED_FRAME_BEAT0 + LED_MAX_BEATS,
+    LED_FRAME_NONE = 0xFF   // Pulse without LED
+};
+
+// WS2812 ring driven by the RMT peripheral. show() hands a precomputed frame
+// to the RMT driver and returns; the bit encoding runs in the RMT ISR.
+class LedRing {
+public:
+    void begin();
+
+    // Lay out the beat frames for a bar of `beats` (ring split into equal
+    // segments, current beat lit, segment starts dimly marked). Call from
+    // one task only; no-op if unchanged.
+    void setBeatsPerBar(int beats);
+
+    // Start sending a frame without blocking. Returns false (frame dropped)
+    // if the previous frame is still on the wire.
+    bool show(uint8_t frame);
+    uint8_t beatFrame(int beat) const { return LED_FRAME_BEAT0 + (beat % _beats); }
+    void clear() { show(LED_FRAME_OFF); }
+
+private:
+    void buildFrames(uint8_t* bank, int beats);
+    static void setPixel(uint8_t* frame, int led, uint8_t r, uint8_t g, uint8_t b);
+    static void IRAM_ATTR translate(const void* src, rmt_item32_t* dest, size_t srcSize,
+                                    size_t wanted, size_t* translated, size_t* itemNum);
+
+    // Two banks so a layout change never rewrites a frame that is on the wire
+    uint8_t _frames[2][LED_FRAME_COUNT][LED_FRAME_BYTES];
+    std::atomic<uint8_t> _activeBank{0};
+    int _beats = 1;
+    bool _initialized = false;
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <Arduino.h>
+
+#define METER_MIN_BEATS 2
+#define METER_MAX_BEATS 12
+#define METER_MAX_TAPS 32       // Longest sequence analysed
+#define METER_MAX_GROUPS 6
+#define METER_MIN_CONFIDENCE 0.6f
+#define METER_MIN_SEPARATION 0.2f // Accent cluster must be this much louder (relative)
+
+struct MeterResult {
+    int beats;                    // Bar length in taps
+    uint8_t groups[METER_MAX_GROUPS]; // Accent grouping, e.g. 2,2,3 for 7/8
+    int groupCount;               // 1 = only the downbeat is accented
+    float confidence;             // 0..1
+};
+
+// Meter from a tap sequence: peak levels are split into accent/normal by
+// 2-means clustering, then every bar length 2..12 is scored by how well
+// the accent pattern repeats at that lag (comb/autocorrelation). The
+// accented positions inside the winning bar give the grouping. A new
+// meter must win twice in a row before it replaces the current one.
+class MeterDetector {
+public:
+    void reset();
+
+    // peaks: oldest first; firstIndex is the tap number of peaks[0] since
+    // the sequence started, so bar positions stay put as old taps drop out
+    // of the window. Overwrites accents[] with the clustered classification
+    // (left as-is when there are too few taps to cluster).
+    // Returns true when the reported meter changes.
+    bool analyze(const float* peaks, int n, uint32_t firstIndex, bool* accents, MeterResult& out);
+
+    bool hasMeter() const { return _current.beats > 0; }
+    const MeterResult& current() const { return _current; }
+
+private:
+    bool cluster(const float* peaks, int n, float* strength, bool* accents);
+    static bool sameMeter(const MeterResult& a, const MeterResult& b);
+
+    MeterResult _current = {};
+    MeterResult _pending = {};
+    int _pendingCount = 0;
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <Arduino.h>
+#include <driver/i2s.h>
+#include <atomic>
+#include "config.h"
+
+#define MIC_SAMPLE_RATE 16000
+#define MIC_RING_SAMPLES 4096 // ~256 ms of history (power of 2)
+#define MIC_DMA_LEN 256       // Samples per DMA buffer = per capture block
+#define MIC_MAX_LISTENERS 2
+
+// Called from the capture task for every block, right after it is in the ring
+typedef void (*MicBlockCallback)(void* ctx, const int32_t* samples, size_t n, uint32_t firstIndex);
+
+class MicStream;
+
+// One consumer's view of the capture ring. Each reader keeps its own
+// cursor, so readers never take samples away from each other. A reader
+// that falls more than the ring behind skips ahead and counts an overrun.
+class MicReader {
+public:
+    void attach(MicStream* stream);
+
+    size_t available() const;
+    // Oldest-first, up to maxSamples; returns the number copied
+    size_t read(int32_t* dst, size_t maxSamples);
+    void skipToLatest();
+
+    uint32_t position() const { return _cursor; } // Stream index of the next sample
+    uint32_t overruns() const { return _overruns; }
+
+private:
+    uint32_t start(uint32_t w) const;
+    MicStream* _stream = nullptr;
+    uint32_t _cursor = 0;
+    uint32_t _overruns = 0;
+};
+
+// Owns I2S_NUM_1 and a capture task that drains it continuously into a
+// lock-free ring (one writer, any number of MicReaders). Samples are the
+// raw 32-bit I2S words; indices are free-running uint32 counts.
+class MicStream {
+public:
+    void begin();   // Installs the driver once; capture starts paused
+    void pause();   // Stops I2S clocks, driver stays installed
+    void resume();
+    bool isRunning() const { return !_paused; }
+
+    // Register sample-accurate processing (e.g. onset detection) in the
+    // capture path. Call before capture starts; keep the work per block short.
+    bool addListener(MicBlockCallback cb, void* ctx);
+
+    uint32_t written() const { return _written.load(std::memory_order_acquire); }
+    uint32_t resumeIndex() const { return _resumeIndex; } // First sample after the last gap
+
+    // esp_timer time at which a sample was captured
+    int64_t sampleToMicros(uint32_t index) const;
+
+    // Copy n samples starting at index; false if the writer overtook them meanwhile
+    bool copy(uint32_t index, int32_t* dst, size_t n) const;
+
+private:
+    static void taskEntry(void* param);
+    void captureLoop();
+
+    int32_t _ring[MIC_RING_SAMPLES];
+    std::atomic<uint32_t> _written{0};
+    volatile uint32_t _resumeIndex = 0;
+    volatile bool _paused = true;
+    TaskHandle_t _taskHandle = NULL;
+
+    struct Listener {
+        MicBlockCallback cb;
+        void* ctx;
+    };
+    Listener _listeners[MIC_MAX_LISTENERS];
+    int _listenerCount = 0;
+
+    // Timestamp anchor (seqlock): the last sample of the latest block
+    std::atomic<uint32_t> _anchorSeq{0};
+    uint32_t _anchorSample = 0;
+    int64_t _anchorUs = 0;
+};
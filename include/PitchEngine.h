@@ -0,0 +1,24 @@
+#pragma once
+#include <Arduino.h>
+
+#define PITCH_MAX_FRAME 256 // Largest frameSize() of any engine (power of 2, sizes Tuner's window)
+
+enum PitchEngineId : uint8_t {
+    PITCH_ENGINE_FFT,
+    PITCH_ENGINE_YIN,
+    PITCH_ENGINE_COUNT
+};
+
+// Fundamental-frequency estimator working on one frame of float samples.
+// Tuner owns one instance of each engine and picks the active one at runtime.
+class PitchEngine {
+public:
+    virtual ~PitchEngine() {}
+    virtual const char* name() const = 0;
+
+    // Samples needed per estimate (at most PITCH_MAX_FRAME)
+    virtual int frameSize() const = 0;
+
+    // Hz, or 0 if no pitch was found. The frame may be used as scratch.
+    virtual float detect(float* frame, float sampleRate) = 0;
+};
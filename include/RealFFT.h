@@ -0,0 +1,137 @@
+#pragma once
+#include <Arduino.h>
+
+// Single-precision FFT for real input of N samples (N power of 2).
+// The N reals are treated in place as N/2 complex points, transformed with
+// an iterative radix-2 FFT and split into the N/2 + 1 real-spectrum bins.
+// Tables: Hamming window (half, symmetric), one quarter-wave cosine table
+// serving both twiddle sets, and the N/2 bit-reverse permutation.
+//
+// Packed output layout (in place):
+//   buf[0] = Re X[0] (DC), buf[1] = Re X[N/2] (Nyquist),
+//   buf[2k], buf[2k+1] = Re, Im of X[k] for k = 1 .. N/2 - 1
+template <int N>
+class RealFFT {
+    static_assert(N >= 16 && (N & (N - 1)) == 0, "N must be a power of 2");
+    static const int M = N / 2; // Complex points
+
+public:
+    void begin() {
+        for (int k = 0; k <= N / 4; k++) _cos[k] = cosf(2.0f * PI * k / N);
+        for (int i = 0; i < N / 2; i++) _win[i] = 0.54f - 0.46f * cosf(2.0f * PI * i / (N - 1));
+        int bits = 0;
+        while ((1 << bits) < M) bits++;
+        for (int i = 0; i < M; i++) {
+            int r = 0;
+            for (int b = 0; b < bits; b++) r |= ((i >> b) & 1) << (bits - 1 - b);
+            _bitrev[i] = (uint16_t)r;
+        }
+    }
+
+    void applyWindow(float* buf) const {
+        for (int i = 0; i < N / 2; i++) {
+            buf[i] *= _win[i];
+            buf[N - 1 - i] *= _win[i];
+        }
+    }
+
+    void forward(float* buf) const {
+        // 1. Bit-reverse permutation of the N/2 complex points
+        for (int i = 0; i < M; i++) {
+            int j = _bitrev[i];
+            if (j > i) {
+                float tr = buf[2 * i], ti = buf[2 * i + 1];
+                buf[2 * i] = buf[2 * j];
+                buf[2 * i + 1] = buf[2 * j + 1];
+                buf[2 * j] = tr;
+                buf[2 * j + 1] = ti;
+            }
+        }
+
+        // 2. Radix-2 butterflies; each twiddle is loaded once per stage
+        for (int size = 2; size <= M; size <<= 1) {
+            const int half = size >> 1;
+            const int step = 2 * (M / size); // Twiddle index in N-space
+            for (int j = 0; j < half; j++) {
+                const float wr = cosN(j * step);
+                const float wi = -sinN(j * step);
+                for (int s = j; s < M; s += size) {
+                    float* a = buf + 2 * s;
+                    float* b = buf + 2 * (s + half);
+                    float br = b[0] * wr - b[1] * wi;
+                    float bi = b[0] * wi + b[1] * wr;
+                    b[0] = a[0] - br;
+                    b[1] = a[1] - bi;
+                    a[0] += br;
+                    a[1] += bi;
+                }
+            }
+        }
+
+        // 3. Split the half-length complex spectrum into the real spectrum
+        float z0r = buf[0], z0i = buf[1];
+        buf[0] = z0r + z0i;
+        buf[1] = z0r - z0i;
+        for (int k = 1; k <= M / 2; k++) {
+            float* zk = buf + 2 * k;
+            float* zm = buf + 2 * (M - k);
+            float evr = 0.5f * (zk[0] + zm[0]);
+            float evi = 0.5f * (zk[1] - zm[1]);
+            float odr = 0.5f * (zk[1] + zm[1]);
+            float odi = -0.5f * (zk[0] - zm[0]);
+            float c = cosN(k), s = sinN(k);
+            float tr = c * odr + s * odi;
+            float ti = c * odi - s * odr;
+            zk[0] = evr + tr;
+            zk[1] = evi + ti;
+            if (k != M - k) {
+                zm[0] = evr - tr;
+                zm[1] = -(evi - ti);
+            }
+        }
+    }
+
+    // Packed spectrum -> power |X[k]|^2 for k = 0 .. N/2 - 1, in place
+    // (reads of bins 2k, 2k+1 always stay ahead of the write at k)
+    static void power(float* buf) {
+        buf[0] = buf[0] * buf[0];
+        for (int k = 1; k < M; k++) {
+            float re = buf[2 * k], im = buf[2 * k + 1];
+            buf[k] = re * re + im * im;
+        }
+    }
+
+    // Strongest bin in [minBin, N/2 - 1) of a power spectrum, refined by
+    // parabolic interpolation over the neighbouring magnitudes. Hz.
+    static float peakFrequency(const float* pow, float sampleRate, int minBin = 1) {
+        int best = -1;
+        float bestPow = 0.0f;
+        for (int k = minBin > 1 ? minBin : 1; k < M - 1; k++) {
+            if (pow[k] > bestPow && pow[k] >= pow[k - 1] && pow[k] >= pow[k + 1]) {
+                best = k;
+                bestPow = pow[k];
+            }
+        }
+        if (best < 0) return 0.0f;
+        float a = sqrtf(pow[best - 1]), b = sqrtf(pow[best]), c = sqrtf(pow[best + 1]);
+        float denom = a - 2.0f * b + c;
+        float delta = (denom != 0.0f) ? 0.5f * (a - c) / denom : 0.0f;
+        return (best + delta) * sampleRate / N;
+    }
+
+private:
+    // cos/sin(2 pi k / N) for 0 <= k <= N/2 from the quarter-wave table
+    inline float cosN(int k) const { return (k <= N / 4) ? _cos[k] : -_cos[N / 2 - k]; }
+    inline float sinN(int k) const { return _cos[k > N / 4 ? k - N / 4 : N / 4 - k]; }
+
+    float _cos[N / 4 + 1];
+    float _win[N / 2];
+    uint16_t _bitrev[M];
+};
+
+#ifdef AUDIO_BENCHMARK
+// Prints cycles and RAM per 1024-point frame for the double-precision
+// complex FFT path vs. RealFFT (Serial). Host build (x86-64, -O2):
+// ~280k vs. ~37k cycles, 16384 vs. 8196 bytes; not yet run on the ESP32.
+void benchmarkFFT();
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Bounded lock-free single-producer/single-consumer ring.
+// Exactly one task may push and exactly one task may pop. Indices run freely
+// and wrap via the power-of-two mask, so "full" and "empty" never alias.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+public:
+    // Producer side. Returns false (and drops nothing already queued) when full.
+    bool push(const T& item) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t head = _head.load(std::memory_order_acquire);
+        if (tail - head >= Capacity) return false;
+        _items[tail & (Capacity - 1)] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: look at the oldest item without removing it
+    bool peek(T& item) const {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) return false;
+        item = _items[head & (Capacity - 1)];
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& item) {
+        if (!peek(item)) return false;
+        _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    T _items[Capacity];
+    std::atomic<uint32_t> _head{0}; // Written by the consumer only
+    std::atomic<uint32_t> _tail{0}; // Written by the producer only
+};
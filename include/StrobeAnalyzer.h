@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#include "PitchEngine.h"
+
+#define STROBE_HARMONICS 4     // Fundamental + 3 overtones
+#define STROBE_MAX_HZ 1500.0f  // Harmonics above this are outside the front-end passband
+#define STROBE_HISTORY 32      // Frames in the drift regression (~0.5 s at 64-sample hops)
+#define STROBE_MAX_GAP 64      // Samples between frames (one tuner hop) before the phase track restarts
+#define STROBE_RANGE_CENTS 50.0f // Deviation each harmonic must resolve without phase aliasing
+
+// Result of the strobe analysis, relative to the locked target note
+struct StrobeReading {
+    int note;       // MIDI note (-1 = not locked)
+    float targetHz; // Equal-tempered frequency of the note for the current A4
+    float cents;    // Deviation from targetHz
+    float phase;    // Accumulated drift of the fundamental, 0..1 turn (what a
+                    // mechanical strobe disc would show)
+};
+
+// Strobe tuner: one generalized Goertzel filter per harmonic of a known
+// target frequency. A tone that is off by df advances its phase by
+// 2*pi*df per second relative to the filter; that drift is accumulated
+// across frames and its slope (least squares over ~0.5 s) is the
+// deviation. Costs one multiply-add per sample and harmonic instead of
+// a full transform.
+class StrobeAnalyzer {
+public:
+    void begin(); // Builds the analysis window
+
+    // Retune the filters; clears the phase track
+    void setTarget(float hz, float sampleRate);
+    float getTarget() const { return _targetHz; }
+
+    // Analyse a frame of n (<= PITCH_MAX_FRAME) samples whose first
+    // sample has stream index start. Frames must share the same n.
+    void process(const float* frame, int n, uint32_t start);
+    void reset(); // Forget the phase track (signal lost)
+
+    bool hasReading() const { return _count >= 4; }
+    float getCents() const { return _cents; }
+    float getPhase() const { return _phase; } // Drift of the fundamental, 0..1 turn
+
+private:
+    float _window[PITCH_MAX_FRAME]; // Hann
+    int _windowLen = 0;
+
+    float _targetHz = 0;
+    float _omega[STROBE_HARMONICS]; // rad/sample, 0 = harmonic unused
+    float _cosW[STROBE_HARMONICS];
+    float _sinW[STROBE_HARMONICS];
+    float _lastPhase[STROBE_HARMONICS];
+    uint32_t _lastStart = 0;
+    bool _havePrev = false;
+
+    // Unwrapped drift of the fundamental (radians) against stream time
+    float _drift[STROBE_HISTORY];
+    uint32_t _time[STROBE_HISTORY];
+    int _head = 0;
+    int _count = 0;
+    float _phase = 0;
+    float _cents = 0;
+};
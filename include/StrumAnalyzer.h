@@ -0,0 +1,77 @@
+#pragma once
+#include <Arduino.h>
+#include "RealFFT.h"
+
+#define STRUM_SAMPLES 2048        // 512 ms at 4 kHz: 1.95 Hz bins, enough to split B0 from E1
+#define STRUM_MAX_STRINGS 6
+#define STRUM_HARMONICS 6         // Partials summed per candidate
+#define STRUM_MAX_HZ 1500.0f      // Partials above this are outside the front-end passband
+#define STRUM_TOLERANCE_CENTS 100 // Search window around each open-string pitch
+#define STRUM_STEP_CENTS 4        // Candidate spacing inside the window
+#define STRUM_MIN_SNR 4.0f        // Harmonic sum vs. the spectrum's median, per partial
+#define STRUM_MIN_SHARE 0.2f      // ...and vs. the strongest string of the strum
+#define STRUM_COLLISION_CENTS 60  // Partials this close to another string's are skipped
+
+enum StrumInstrument : uint8_t {
+    STRUM_GUITAR,   // E2 A2 D3 G3 B3 E4
+    STRUM_BASS4,    // E1 A1 D2 G2
+    STRUM_BASS5,    // B0 E1 A1 D2 G2
+    STRUM_INSTRUMENT_COUNT
+};
+
+// One string of a strum, small enough to render all of them per frame
+struct StrumString {
+    uint8_t note;     // MIDI note of the open string
+    uint8_t level;    // 0 = not heard, 255 = strongest string of the strum
+    int16_t centsX10; // Deviation from the open-string pitch, 0.1 cent units
+};
+
+struct StrumResult {
+    uint8_t count; // Strings of the instrument
+    StrumString strings[STRUM_MAX_STRINGS];
+};
+
+// Polyphonic open-string tuner: every string is looked for in its own
+// tolerance window by summing the magnitude spectrum at the candidate's
+// partials (harmonic sum spectrum). The best candidate per window gives
+// that string's pitch; the sum against the spectrum's noise floor and
+// the other strings says whether the string is ringing at all. Partials
+// that land on another string's (E2's 3rd on B3, 4th on E4) are left out
+// of the sum, so a string is measured by the partials it owns.
+//
+// The 2048-sample window, analysis frame and FFT tables (~24 KB) live on
+// the heap between begin() and end() only, so the single-note tuner
+// doesn't pay for them.
+class StrumAnalyzer {
+public:
+    ~StrumAnalyzer() { end(); }
+
+    bool begin(); // Allocates the buffers; false if the heap is short
+    void end();   // Frees them
+    bool isReady() const { return _fft != nullptr; }
+
+    void setInstrument(StrumInstrument instrument);
+    StrumInstrument getInstrument() const { return _instrument; }
+    static const char* instrumentName(StrumInstrument instrument);
+
+    // Sliding window of the newest STRUM_SAMPLES samples
+    void push(int32_t sample) {
+        _history[_histHead++ & (STRUM_SAMPLES - 1)] = (float)sample;
+        if (_histFill < STRUM_SAMPLES) _histFill++;
+    }
+    void clear() { _histFill = 0; } // Capture gap: the window no longer joins up
+    bool isFull() const { return _histFill == STRUM_SAMPLES; }
+
+    // Analyse the current window for the given A4
+    void analyze(float sampleRate, float a4Ref, StrumResult& out);
+
+private:
+    RealFFT<STRUM_SAMPLES>* _fft = nullptr;
+    float* _history = nullptr; // STRUM_SAMPLES ring
+    float* _frame = nullptr;   // STRUM_SAMPLES, unrolled window and FFT scratch
+    uint32_t _histHead = 0;
+    uint32_t _histFill = 0;
+    StrumInstrument _instrument = STRUM_GUITAR;
+    uint8_t _partials[STRUM_MAX_STRINGS]; // Bit h-1 set: partial h is summed
+    float harmonicSum(const float* mag, float hz, float binHz, uint8_t partials) const;
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "SpscQueue.h"
+#include "MicStream.h"
+#include "AudioEngine.h"
+
+#define TAP_QUEUE_LEN 16
+#define TAP_REFRACTORY_MS 60  // Min time between onsets (debounce), ~1000 BPM
+#define TAP_PEAK_WINDOW_MS 50 // Peak level is measured over this window after the onset
+#define TAP_MIN_LEVEL 200.0f  // Absolute floor for the threshold (mic units >> 14)
+#define TAP_ACCENT_RATIO 1.4f // Peak vs. running average of earlier peaks
+
+// Self-click suppression: while one of our own clicks reaches the mic the
+// threshold follows its known envelope, scaled by the learned speaker->mic coupling
+#define TAP_ACOUSTIC_LATENCY_US 1500 // DAC -> speaker -> mic -> capture timestamp (default)
+#define TAP_CLICK_SLACK_US 3000      // Timing uncertainty around the expected arrival
+#define TAP_CLICK_MARGIN 2.0f        // A tap must beat the expected click level by this
+#define TAP_CLICK_SCAN 16            // Samples between envelope evaluations (1 ms)
+#define TAP_MAX_CLICKS 4             // Overlapping clicks considered at once
+#define TAP_COUPLING_TAIL 3          // Click time constants used to measure the coupling
+
+struct TapOnset {
+    uint32_t sample; // Mic stream index of the first sample over the threshold
+    int64_t us;      // esp_timer time of that sample minus the acoustic latency,
+                     // i.e. on the output clock: a tap in time with a click
+                     // lands on that click's heardUs
+    float peak;      // Envelope peak inside the peak window
+    bool accent;
+};
+
+// Per-sample onset detector running inside the mic capture task: a peak
+// envelope follower against an adaptive threshold (noise floor x ratio).
+// Onsets are classified (peak, accent) in the same pass and handed to the
+// UI through an SPSC queue.
+// When an audio engine is attached, its clicks raise the threshold by their
+// expected level at the mic, so the metronome (and tap feedback) can play at
+// full volume without triggering taps.
+class TapDetector {
+public:
+    void begin(MicStream* mic);
+
+    // Optional: clicks from this engine are never taken for taps
+    void setClickSource(const AudioEngine* audio) { _audio = audio; }
+    // Output-to-input delay of the click path (calibrated or default)
+    void setAcousticLatencyUs(int32_t us) { _latencyUs = us; }
+    int32_t getAcousticLatencyUs() const { return _latencyUs; }
+
+    // 0.1 (needs hard taps) .. 1.0 (most sensitive)
+    void setSensitivity(float s) { _sensitivity = s; }
+
+    // Consumer side (UI task only)
+    bool poll(TapOnset& onset) { return _onsets.pop(onset); }
+    void flush();
+
+    // Current envelope relative to the threshold (1.0 = would trigger)
+    float getLevel() const { return _level; }
+
+private:
+    static void onBlockCb(void* ctx, const int32_t* samples, size_t n, uint32_t firstIndex);
+    void process(const int32_t* samples, size_t n, uint32_t firstIndex);
+    float expectedClick(int64_t us, const ClickEmission*& onset) const;
+    void measureClick(int64_t us, const ClickEmission* onset);
+    void learnCoupling();
+
+    MicStream* _mic = nullptr;
+    const AudioEngine* _audio = nullptr;
+    volatile int32_t _latencyUs = TAP_ACOUSTIC_LATENCY_US;
+    SpscQueue<TapOnset, TAP_QUEUE_LEN> _onsets;
+    volatile float _sensitivity = 0.5f;
+    volatile float _level = 0.0f;
+
+    // Capture-task state
+    float _env = 0.0f;
+    float _floor = TAP_MIN_LEVEL;
+    float _peakAvg = 0.0f;
+    bool _inPeak = false;
+    float _peak = 0.0f;
+    uint32_t _onsetIndex = 0;
+    uint32_t _sinceOnset = 0xFFFFFFFF;
+
+    // Click suppression (capture task)
+    ClickEmission _clicks[TAP_MAX_CLICKS];
+    size_t _clickCount = 0;
+    float _coupling = 0.0f;     // Mic envelope per unit of output level (0 = not learned yet)
+    int64_t _measureUs = 0;      // Click being measured (its heardUs, 0 = none)
+    float _measureLevel = 0.0f;
+    float _measureDecayUs = 0.0f;
+    bool _measureRising = false; // Still inside its arrival window
+    float _measurePeak = 0.0f;   // Envelope peak around the arrival...
+    int64_t _measurePeakUs = 0;  // ...and when it happened
+    float _measureMin = 0.0f;    // Lowest envelope / decay curve along the tail
+    bool _measureTapped = false; // A tap overlapped it: not a clean measurement
+
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+
+#define TEMPO_WINDOW 8          // Intervals kept in the sliding window
+#define TEMPO_TOLERANCE 0.25f   // Relative deviation still counted as "on tempo"
+#define TEMPO_CHANGE_TAPS 3     // Consistent off-tempo intervals that mean a real tempo change
+
+// Tap-tempo estimate over a sliding window of inter-onset intervals.
+// The period is the trimmed mean (middle half) of the window, which is
+// kept sorted incrementally. Intervals near half the period are treated as
+// doubled taps and skipped; near twice the period as missed taps and split.
+// Other outliers are rejected unless they repeat, which restarts the
+// window at the new tempo.
+class TempoEstimator {
+public:
+    void reset();
+
+    // Feed one onset; true if the estimate changed
+    bool addOnset(int64_t us);
+
+    bool hasEstimate() const { return _count > 0; }
+    float getBpm() const { return _periodUs > 0 ? 60000000.0f / _periodUs : 0.0f; }
+    int intervalCount() const { return _count; }
+    int64_t lastOnsetUs() const { return _lastUs; }
+
+private:
+    void push(float interval);
+    void update();
+
+    float _ring[TEMPO_WINDOW];   // Arrival order
+    float _sorted[TEMPO_WINDOW]; // Same values, ascending
+    int _head = 0;
+    int _count = 0;
+    float _periodUs = 0.0f;
+    int64_t _lastUs = 0;
+    bool _haveLast = false;
+
+    // Candidate tempo change (consecutive intervals with the same ratio)
+    int _pendingKind = 0; // 0 = none, 1 = half, 2 = double, 3 = other
+    int _pendingCount = 0;
+    float _pendingSum = 0.0f;
+    int _onTempoRun = 0;
+};
@@ -1,51 +1,116 @@
 #pragma once
 #include <Arduino.h>
-#include <driver/i2s.h>
-#include "arduinoFFT.h"
 #include "config.h"
+#include "MicStream.h"
+#include "FftPitchEngine.h"
+#include "YinPitchEngine.h"
+#include "TunerFrontEnd.h"
+#include "StrobeAnalyzer.h"
+#include "StrumAnalyzer.h"
 
-#ifndef FFT_DIR_FORWARD
-#define FFT_DIR_FORWARD FFT_FORWARD
-#endif
-
-#define MIC_SAMPLE_RATE 16000
-#define FFT_SAMPLES 1024 // Power of 2
 #define NOISE_THRESHOLD 1000 // FFT Threshold
-#define TAP_THRESHOLD 5000000 // Raw Amplitude Threshold (needs tuning depending on scaling)
+#define TUNER_HOP_SAMPLES 64  // New samples per estimate (~60 updates/s at 4 kHz)
+#define TUNER_MIN_HOP 16
+#define TUNER_MEDIAN_LEN 5    // Estimates in the median filter (odd)
+#define TUNER_SMOOTHING 0.35f // Exponential smoothing of the median, per estimate
+#define TUNER_SNAP_CENTS 60   // Jumps larger than this restart the smoother
+#define STROBE_HOP_SAMPLES 64 // The strobe analyses every hop of this size as it arrives
+#define STROBE_COARSE_HOPS 4  // While locked, the pitch engine runs every 4th estimate only
+#define STROBE_RELOCK 3       // Coarse estimates on another note before the strobe follows
+#define STRUM_HOP_SAMPLES 512 // Strum analysis rate (~8/s; each covers STRUM_SAMPLES)
 
 class Tuner {
 public:
     Tuner();
-    void begin();
-    void stop(); // Stop I2S to save power/conflict
+    void begin(MicStream* mic); // Attaches readers; capture is paused/resumed on the stream
 
     // Configure concert pitch
-    void setA4Reference(float hz) { _a4Ref = hz; }
+    void setA4Reference(float hz) { _a4Ref = hz; unlockStrobe(); }
     float getA4Reference() const { return _a4Ref; }
+
+    // Pitch detection algorithm (see PitchEngineId); takes effect on the
+    // next estimate
+    void setEngine(PitchEngineId id);
+    PitchEngineId getEngine() const { return _engineId; }
+    const char* getEngineName() const { return _engine->name(); }
+
+    // Strobe mode: once the engine has found the note, Goertzel filters on
+    // its fundamental and overtones measure the deviation to a fraction of
+    // a cent; getFrequency() then returns the fine estimate
+    void setStrobe(bool on);
+    bool isStrobe() const { return _strobeOn; }
+    bool getStrobe(StrobeReading& out) const; // False until locked and settled
+
+    // Strum mode: every open string of the instrument from one strum,
+    // analysed instead of the single-note pitch (-1 = off)
+    void setStrum(int instrument);
+    int getStrum() const { return _strumOn ? _strumAnalyzer.getInstrument() : -1; }
+    bool getStrumResult(StrumResult& out) const; // False until a strum was heard
     
-    // Returns frequency in Hz, or 0 if silent/noise
+    // Returns frequency in Hz, or 0 if silent/noise. Never blocks: the
+    // analysis window slides by one hop at a time, and between hops the
+    // previous (smoothed) estimate is returned.
     float getFrequency();
 
-    // Returns simple RMS level for tap detection / AGC debug
-    float readLevel();
-    
-    // Returns raw max amplitude (for tap detection)
-    int32_t getAmplitude(); 
-    
+    // Samples the window advances per estimate; a hop equal to the frame
+    // size gives non-overlapping blocks
+    void setHop(int samples);
+    int getHop() const { return _hop; }
+
     // Helper to get Note name and Cents deviation
     // returns string like "A4", fills cents (-50 to +50)
     String getNote(float frequency, int &cents);
 
 private:
-    arduinoFFT FFT;
-    
-    // I2S Read Buffers
-    int32_t i2s_raw_buffer[FFT_SAMPLES]; // INMP441 is 24-bit (32bit container)
-    double vReal[FFT_SAMPLES];
-    double vImag[FFT_SAMPLES];
+    FftPitchEngine _fftEngine;
+    YinPitchEngine _yinEngine;
+    PitchEngine* _engine = &_fftEngine;
+    PitchEngineId _engineId = PITCH_ENGINE_FFT;
+
+    // Reads the capture ring at the tuner's own pace
+    MicReader _pitchReader;
+
+    // Sliding window at TUNER_SAMPLE_RATE: every captured sample goes
+    // through the front-end once and the result stays in this ring for the
+    // following overlapping frames
+    int32_t _history[PITCH_MAX_FRAME];
+    uint32_t _histHead = 0;  // Next write position (free-running)
+    uint32_t _histFill = 0;  // Contiguous samples held (capped at PITCH_MAX_FRAME)
+    uint32_t _histCursor = 0; // Stream index expected next, to spot gaps
+    int _hop = TUNER_HOP_SAMPLES;
+    int _hopCount = 0;       // New samples since the last estimate
+    TunerFrontEnd _frontEnd;
+    void fillWindow();
+
+    // Analysis frame handed to the engine (which may use it as scratch)
+    float _frame[PITCH_MAX_FRAME];
+
+    // Median + exponential tracker over the raw estimates
+    float _recent[TUNER_MEDIAN_LEN] = {};
+    int _recentHead = 0;
+    float _smoothed = 0;
+    float track(float hz);
+
+    StrobeAnalyzer _strobe;
+    bool _strobeOn = false;
+    int _strobeNote = -1; // MIDI note the filters are tuned to
+    int _relockCount = 0;
+    int _coarseSkip = 0;
+    int _strobeHopCount = 0; // New samples since the last strobe frame
+    void feedStrobe();
+    void updateStrobeTarget(float hz);
+    void unlockStrobe();
+    float getStrobeFrequency() const;
+
+    StrumAnalyzer _strumAnalyzer;
+    StrumResult _strumResult;
+    bool _strumOn = false;
+    bool _strumValid = false;
+
+    float noteFrequency(int note) const { return _a4Ref * powf(2.0f, (note - 69) / 12.0f); }
     
     bool _initialized = false;
+    float _lastFrequency = 0;
 
-    float _agcGain = 1.0f;
     float _a4Ref = 440.0f;
 };
@@ -0,0 +1,57 @@
+#pragma once
+#include <Arduino.h>
+#include "MicStream.h"
+
+#define TUNER_DECIMATION 4
+#define TUNER_SAMPLE_RATE (MIC_SAMPLE_RATE / TUNER_DECIMATION) // 4 kHz analysis rate
+#define FRONTEND_FIR_TAPS 48         // Anti-alias FIR length (multiple of TUNER_DECIMATION)
+#define FRONTEND_FIR_CUTOFF_HZ 2000  // -6 dB point; flat to ~1.45 kHz, stop from ~2.55 kHz
+#define FRONTEND_HPF_HZ 25           // Rumble/handling noise, below B0 (30.9 Hz)
+#define FRONTEND_BLOCK 64            // Output samples per AGC/level update (16 ms)
+#define FRONTEND_AGC_TARGET 8000.0f  // RMS the AGC steers towards
+#define FRONTEND_AGC_STEP 0.025f     // Gain smoothing per block
+#define FRONTEND_CLAMP 8388607       // Output range after the AGC (24-bit)
+
+// Fixed-point conditioning of the raw mic stream for pitch analysis:
+// scale the I2S words, remove DC, decimate by 4 through a polyphase
+// anti-alias FIR, high-pass the result and apply the AGC. Every sample is
+// processed exactly once here, whichever analyses read the output.
+class TunerFrontEnd {
+public:
+    void begin(); // Designs the filters
+    void reset(); // Clears filter state after a gap in the input
+
+    // Consumes n raw I2S words, writes the decimated samples to out (room
+    // for n / TUNER_DECIMATION + 1) and returns how many were written
+    size_t process(const int32_t* raw, size_t n, int32_t* out);
+
+    float getLevel() const { return _level; } // Mean |x| before the AGC, latest block
+    float getRms() const { return _rms; }     // RMS after the AGC, latest block
+    float getGain() const { return _gainQ16 / 65536.0f; }
+
+private:
+    // DC blocker: y = x - x[-1] + (1 - 2^-8) y[-1], ~10 Hz at 16 kHz.
+    // The feedback state keeps 8 fractional bits so it doesn't drift.
+    int32_t _dcPrev = 0;
+    int32_t _dcAcc = 0;
+
+    // Decimator: the delay line is stored twice so every output is one
+    // contiguous dot product; only every TUNER_DECIMATION-th output exists
+    int16_t _firTaps[FRONTEND_FIR_TAPS];   // Q15, reversed (oldest sample first)
+    int32_t _firLine[2 * FRONTEND_FIR_TAPS];
+    int _firPos = 0;
+    int _firPhase = 0;
+
+    // High-pass biquad at the output rate (direct form I, Q28 coefficients)
+    int32_t _b0, _b1, _b2, _a1, _a2;
+    int32_t _x1 = 0, _x2 = 0, _y1 = 0, _y2 = 0;
+    int32_t _hpErr = 0; // Q28 fraction carried between samples
+
+    // AGC and level
+    int32_t _gainQ16 = 65536;
+    int64_t _blockSq = 0;
+    int64_t _blockAbs = 0;
+    int _blockCount = 0;
+    float _level = 0;
+    float _rms = 0;
+};
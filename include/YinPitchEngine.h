@@ -0,0 +1,33 @@
+#pragma once
+#include "PitchEngine.h"
+
+#define YIN_FRAME_SAMPLES 256    // 64 ms at the 4 kHz analysis rate
+#define YIN_MAX_LAG 132          // Lowest pitch ~30 Hz (B0 on a 5-string bass)
+#define YIN_MIN_LAG 2            // Dips from lag 3 (~1.3 kHz) up are interpolated
+#define YIN_THRESHOLD 0.15f      // Dip in the normalized difference that counts as periodic
+#define YIN_UNVOICED 0.35f       // Above this even the best dip is treated as noise
+#define YIN_UPSAMPLE 4           // Lag resolution of the final refinement (1/4 sample)
+#define YIN_INTERP_TAPS 8        // Interpolation filter taps per output sample
+#define YIN_WINDOW (YIN_FRAME_SAMPLES - YIN_MAX_LAG - 1) // Integration window, every lag fits
+
+// YIN (de Cheveigne & Kawahara): the first lag whose cumulative-mean-
+// normalized difference dips below a threshold is the period, which
+// favours the fundamental over its harmonics. The difference function is
+// built as energy(j) + energy(j + tau) - 2 * correlation, with both energy
+// terms updated incrementally per lag, and the lag scan stops at the
+// first qualifying dip, so high notes cost only a few dozen lags.
+// The winning dip is then refined on an upsampled copy of the frame.
+class YinPitchEngine : public PitchEngine {
+public:
+    void begin(); // Builds the interpolation filter
+    const char* name() const override { return "YIN"; }
+    int frameSize() const override { return YIN_FRAME_SAMPLES; }
+    float detect(float* frame, float sampleRate) override;
+
+private:
+    float _cmnd[YIN_MAX_LAG + 1]; // Cumulative-mean-normalized difference per lag
+    float _interp[YIN_UPSAMPLE][YIN_INTERP_TAPS];
+    float _fine[YIN_WINDOW * YIN_UPSAMPLE]; // Upsampled integration window
+    float fineSample(const float* x, int index) const;
+    float refine(const float* x, float coarse);
+};
@@ -6,8 +6,10 @@
 #define I2C_SCL_PIN     22
 
 // --- visual feedback (WS2812) -----------------------------------------------
-#define WS2812_PIN      4   // External NeoPixel
-#define WS2812_NUM_LEDS 1
+#define WS2812_PIN      4   // External NeoPixel ring
+#define WS2812_NUM_LEDS 16
+#define LED_RMT_CHANNEL 0
+#define LED_BRIGHTNESS  200 // 0-255, applied when frames are built
 
 // --- Audio Configuration ----------------------------------------------------
 #define SAMPLE_RATE     44100
@@ -15,6 +17,7 @@
 #define APP_VERSION     "1.3.0"
 #define AUDIO_TASK_CORE 0
 #define AUDIO_TASK_PRIO 2     // Higher than Loop (1)
+// #define AUDIO_BENCHMARK    // Print synthesis cycles per chunk on Serial
 
 // --- audio output (I2S Amp) -------------------------------------------------
 #define I2S_DOUT      19
@@ -25,11 +28,15 @@
 #define I2S_MIC_SD    35 // Input Only
 #define I2S_MIC_WS    23
 #define I2S_MIC_SCK   18
+#define MIC_TASK_CORE 1
+#define MIC_TASK_PRIO 2       // Above Loop so DMA never overflows while drawing
 
 // --- haptics (PWM) ---------------------------------------------------------
 #define HAPTIC_PIN     13
 #define HAPTIC_PWM_FREQ 200
 #define HAPTIC_PWM_CH   3
+#define FEEDBACK_TASK_CORE 1
+#define FEEDBACK_TASK_PRIO 3  // Only arms timers; above Loop so pulses are never late
 
 // --- rotary encoder ---------------------------------------------------------
 #define ENC_PIN_A     33
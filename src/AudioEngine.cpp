@@ -1,18 +1,90 @@
 #include "AudioEngine.h"
+#include <esp_timer.h>
+
+// "Woodblock" timbres: high frequency sine with exponential decay.
+// Rendered once into the click cache, so richer timbres cost nothing at runtime.
+struct ClickTimbre {
+    float freq;
+    float decay;   // Per-sample envelope factor at SAMPLE_RATE (see decayAt)
+    float glideTo; // Pitch follows the envelope from freq down to this (0 = fixed)
+};
+
+static const ClickTimbre kClickTimbres[CLICK_TYPES] = {
+    { 1600.0f, 0.9985f,  0.0f   }, // CLICK_NORMAL: 0.9985 ^ 2000 samples (~45ms at 44.1 kHz) -> ~0.05 amplitude
+    { 2500.0f, 0.9985f,  0.0f   }, // CLICK_ACCENT: higher pitch for the downbeat
+    { 2000.0f, 0.995f,   0.0f   }, // CLICK_SUB: higher/thinner, faster decay (shorter tick)
+    { 4000.0f, 0.99773f, 500.0f }  // CLICK_CHIRP: ~10 ms decay, 4 kHz -> 500 Hz (sharp correlation peak)
+};
+
+// Envelope factor per sample at another rate, so a click rings equally long
+// in every output profile
+static float decayAt(const ClickTimbre& timbre, uint32_t sampleRate) {
+    return powf(timbre.decay, (float)SAMPLE_RATE / (float)sampleRate);
+}
+
+// Renders a timbre at unity gain; decay is the envelope factor per output sample
+static void renderTimbre(const ClickTimbre& timbre, float decay, uint32_t sampleRate, int16_t* dst, uint32_t length) {
+    Oscillator osc;
+    osc.setFrequency(timbre.freq, sampleRate);
+    float env = 1.0f;
+    for (uint32_t i = 0; i < length; i++) {
+        if (timbre.glideTo > 0.0f) osc.setFrequency(timbre.glideTo + (timbre.freq - timbre.glideTo) * env, sampleRate);
+        dst[i] = (int16_t)lrintf((float)osc.nextQ15() * env);
+        env *= decay;
+    }
+}
+
+static const int32_t kToneGainQ15 = 22938; // 0.7: continuous tone lower gain
+
+// Adds a Q32.32 offset to a split (whole, fraction) sample position
+static inline void addSamplesQ32(uint64_t& whole, uint32_t& frac, uint64_t q32) {
+    uint64_t f = (uint64_t)frac + (q32 & 0xFFFFFFFFULL);
+    whole += (q32 >> 32) + (f >> 32);
+    frac = (uint32_t)f;
+}
+
+// Clicks don't need 44.1 kHz: halving the rate halves synthesis and I2S/DMA traffic
+const AudioProfile kAudioProfiles[AUDIO_PROFILE_COUNT] = {
+    // name       rate   bufs  len  chunk    DMA ring
+    { "Low Lat", 44100,  4,  128,  64 },  // 512 frames  ~12 ms
+    { "Normal",  44100,  8,  256, 128 },  // 2048 frames ~46 ms
+    { "Battery", 22050,  6,  256, 256 }   // 1536 frames ~70 ms
+};
 
 AudioEngine::AudioEngine() {
 }
 
 void AudioEngine::begin() {
+    Oscillator::initTable();
+
+    _activeProfile = _requestedProfile;
+    installDriver(kAudioProfiles[_activeProfile]);
+    renderClickCache();
+
+    _beatQueue = xQueueCreate(16, sizeof(BeatEvent));
+
+    // Launch Audio Task
+    xTaskCreatePinnedToCore(
+        AudioEngine::taskEntry,
+        "AudioTask",
+        4096,
+        this,
+        AUDIO_TASK_PRIO,
+        &_audioTaskHandle,
+        AUDIO_TASK_CORE
+    );
+}
+
+void AudioEngine::installDriver(const AudioProfile& profile) {
     i2s_config_t i2s_config = {
         .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
-        .sample_rate = SAMPLE_RATE,
+        .sample_rate = profile.sampleRate,
         .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
         .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
         .communication_format = I2S_COMM_FORMAT_STAND_I2S,
         .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-        .dma_buf_count = 8,
-        .dma_buf_len = 256
+        .dma_buf_count = profile.dmaBufCount,
+        .dma_buf_len = profile.dmaBufLen
     };
     
     i2s_pin_config_t pin_config = {
@@ -26,16 +98,59 @@ void AudioEngine::begin() {
     i2s_set_pin(I2S_NUM_0, &pin_config);
     i2s_zero_dma_buffer(I2S_NUM_0);
 
-    // Launch Audio Task
-    xTaskCreatePinnedToCore(
-        AudioEngine::taskEntry,
-        "AudioTask",
-        4096,
-        this,
-        AUDIO_TASK_PRIO,
-        &_audioTaskHandle,
-        AUDIO_TASK_CORE
-    );
+    _sampleRate = profile.sampleRate;
+    _latencySamples = (uint32_t)profile.dmaBufCount * profile.dmaBufLen + profile.chunkSamples;
+    resetEpoch();
+}
+
+// The DMA ring was just zeroed: the next sample we submit plays after it
+void AudioEngine::resetEpoch() {
+    const AudioProfile& profile = kAudioProfiles[_activeProfile];
+    const uint32_t ring = (uint32_t)profile.dmaBufCount * profile.dmaBufLen;
+    _epochSample = _sampleClock;
+    _epochUs = esp_timer_get_time() + (int64_t)ring * 1000000LL / _sampleRate;
+    _epochLocked = false;
+    publishClock();
+}
+
+void AudioEngine::setProfile(AudioProfileId id) {
+    if (id >= AUDIO_PROFILE_COUNT) return;
+    _requestedProfile = id;
+    wakeIfIdle();
+}
+
+uint32_t AudioEngine::getOutputLatencyUs() const {
+    return (uint32_t)((uint64_t)_latencySamples * 1000000ULL / _sampleRate);
+}
+
+void AudioEngine::applyProfile(AudioProfileId id) {
+    const uint32_t oldRate = _sampleRate;
+    _activeProfile = id;
+
+    // Voices point into the click cache, which is re-rendered below
+    _activeVoices = 0;
+
+    i2s_driver_uninstall(I2S_NUM_0);
+    installDriver(kAudioProfiles[id]);
+    renderClickCache();
+    if (_toneOn) _toneOsc.setFrequency(_toneHz, _sampleRate);
+
+    // Keep the running beat grid in time: rescale distances from "now"
+    if (_schedActive && oldRate != _sampleRate) {
+        const double ratio = (double)_sampleRate / (double)oldRate;
+        double sinceBeat = (double)(_sampleClock - _beatStart) - _beatStartFrac / 4294967296.0;
+        double beatStart = (double)_sampleClock - sinceBeat * ratio;
+        if (beatStart < 0.0) beatStart = 0.0;
+        _beatStart = (uint64_t)beatStart;
+        _beatStartFrac = (uint32_t)((beatStart - (double)_beatStart) * 4294967296.0);
+        _beatLenQ32 = (uint64_t)((double)_beatLenQ32 * ratio);
+
+        uint64_t offset = _clickIndex ? (_beatLenQ32 / _clicksThisBeat) * _clickIndex : _beatLenQ32;
+        _nextEvent = _beatStart;
+        _nextEventFrac = _beatStartFrac;
+        addSamplesQ32(_nextEvent, _nextEventFrac, offset);
+        if (_nextEvent < _sampleClock) _nextEvent = _sampleClock;
+    }
 }
 
 void AudioEngine::taskEntry(void* param) {
@@ -47,6 +162,8 @@ void AudioEngine::taskEntry(void* param) {
 void AudioEngine::setVolume(uint8_t volume) {
     if (volume > 100) volume = 100;
     _volume = volume;
+    AudioCommand cmd = { 0, CMD_VOLUME, CLICK_NORMAL, (float)volume };
+    sendCommand(cmd);
 }
 
 uint8_t AudioEngine::getVolume() {
@@ -60,132 +177,576 @@ bool AudioEngine::wasOverdriven() {
 }
 
 void AudioEngine::stopTone() {
-    _isTonePlaying = false;
+    AudioCommand cmd = { 0, CMD_TONE_OFF, CLICK_NORMAL, 0.0f };
+    sendCommand(cmd);
 }
 
 void AudioEngine::startTone(float frequency) {
-    _toneFreq = frequency;
-    _isTonePlaying = true;
+    AudioCommand cmd = { 0, CMD_TONE_ON, CLICK_NORMAL, frequency };
+    sendCommand(cmd);
+}
+
+bool AudioEngine::sendCommand(const AudioCommand& cmd) {
+    // Find (or claim) the lane owned by the calling task
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    CommandLane* lane = nullptr;
+    for (int i = 0; i < AUDIO_CMD_LANES && !lane; i++) {
+        if (_lanes[i].owner.load(std::memory_order_acquire) == self) lane = &_lanes[i];
+    }
+    for (int i = 0; i < AUDIO_CMD_LANES && !lane; i++) {
+        TaskHandle_t expected = NULL;
+        if (_lanes[i].owner.compare_exchange_strong(expected, self)) lane = &_lanes[i];
+    }
+    bool ok;
+    if (lane) {
+        ok = lane->queue.push(cmd);
+    } else {
+        // More producers than lanes: the shared lane, one producer at a time
+        CommandLane& shared = _lanes[AUDIO_CMD_LANES];
+        portENTER_CRITICAL(&_sharedLaneLock);
+        ok = shared.queue.push(cmd);
+        portEXIT_CRITICAL(&_sharedLaneLock);
+    }
+    if (!ok) {
+        // Powers of two only, so a stuck queue doesn't flood the log
+        uint32_t dropped = _droppedCommands.fetch_add(1, std::memory_order_relaxed) + 1;
+        if ((dropped & (dropped - 1)) == 0) Serial.printf("Audio: command queue full, %u dropped\n", dropped);
+    }
+    wakeIfIdle();
+    return ok;
+}
+
+void AudioEngine::wakeIfIdle() {
+    // Pairs with the fence in audioLoop(): either the audio task sees our
+    // command/start flag, or we see it parked and notify it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_idle.load(std::memory_order_relaxed) && _audioTaskHandle) {
+        xTaskNotifyGive(_audioTaskHandle);
+    }
+}
+
+bool AudioEngine::hasPendingWork() const {
+    if (_metroRunning || _toneOn || _activeVoices > 0) return true;
+    if (_requestedProfile != _activeProfile) return true;
+    for (int i = 0; i <= AUDIO_CMD_LANES; i++) {
+        if (!_lanes[i].queue.empty()) return true;
+    }
+    return false;
+}
+
+bool AudioEngine::scheduleClick(ClickType type, float gain, uint64_t atSample) {
+    AudioCommand cmd = { atSample, CMD_CLICK, type, gain };
+    return sendCommand(cmd);
+}
+
+AudioClock AudioEngine::getClock() const {
+    uint32_t seq;
+    AudioClock clock;
+    do {
+        seq = _clockSeq.load(std::memory_order_acquire);
+        clock = _clockPublished;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != _clockSeq.load(std::memory_order_acquire));
+    return clock;
+}
+
+uint64_t AudioEngine::getSampleClock() const {
+    return getClock().submitted;
+}
+
+uint64_t AudioEngine::getPlayheadSample() const {
+    AudioClock clock = getClock();
+    int64_t behind = (clock.epochUs - esp_timer_get_time()) * (int64_t)clock.rate / 1000000LL;
+    // Right after start-up the DAC is still playing the zeroed ring
+    if (behind > 0 && (uint64_t)behind > clock.epochSample) return 0;
+    return clock.epochSample - behind;
+}
+
+int64_t AudioEngine::getNextBeatMicros() const {
+    AudioClock clock = getClock();
+    return clock.nextBeat ? clock.sampleToMicros(clock.nextBeat) : 0;
+}
+
+void AudioEngine::setTempo(float bpm) {
+    if (bpm < 20.0f) bpm = 20.0f;
+    if (bpm > 400.0f) bpm = 400.0f;
+    _bpm = bpm;
+    if (!_metroRunning) _tempoNow = bpm;
+}
+
+void AudioEngine::setTempoRamp(float targetBpm, float bpmPerBeat) {
+    if (targetBpm < 20.0f) targetBpm = 20.0f;
+    if (targetBpm > 400.0f) targetBpm = 400.0f;
+    _rampTarget = targetBpm;
+    _rampPerBeat = fabsf(bpmPerBeat);
+    _rampActive = (bpmPerBeat != 0.0f);
+}
+
+void AudioEngine::setBeatsPerBar(int beats) {
+    if (beats < 1) beats = 1;
+    if (beats > 16) beats = 16;
+    _beatsPerBar = beats;
+}
+
+void AudioEngine::setSubdivision(int clicksPerBeat) {
+    if (clicksPerBeat < 1) clicksPerBeat = 1;
+    if (clicksPerBeat > 4) clicksPerBeat = 4;
+    _clicksPerBeat = clicksPerBeat;
+}
+
+void AudioEngine::startMetronome() {
+    _metroRestart = true;
+    _metroRunning = true;
+    wakeIfIdle();
+}
+
+void AudioEngine::stopMetronome() {
+    _metroRunning = false;
+}
+
+bool AudioEngine::getBeatEvent(BeatEvent& evt, TickType_t wait) {
+    if (!_beatQueue) return false;
+    return xQueueReceive(_beatQueue, &evt, wait) == pdTRUE;
 }
 
 void AudioEngine::playClick(bool isAccent, bool isSubdivision) {
     // Signal the task
-    _triggerClickAccent = isAccent;
-    _triggerClickSub = isSubdivision;
-    _triggerClick = true;
+    if (isSubdivision) scheduleClick(CLICK_SUB, 0.4f); // Soft volume for sub
+    else scheduleClick(isAccent ? CLICK_ACCENT : CLICK_NORMAL, 1.0f);
     
-    // Fire callback for haptics/LED immediately (UI thread)
-    // Only fire main beat callback for normal beats, or maybe implement a separate one?
-    // Current design: Haptics fire on every 'playClick'.
-    // We update callback to only fire HARD on beats, SOFT on subs?
-    // User requested features 1, 2, 3, 5. 2 is Subdivisions.
-    if (_beatCallback) {
-        // If it's a subdivision, we might want weaker feedback?
-        // For now, pass 'accent' state as false for Subdivisions, but maybe we need a param.
-        // Actually, main.cpp handles haptics based on 'accent' param.
-        // If we pass false, it gives a normal beat pulse.
-        // Subdivision should probably be NO haptics or very weak?
-        // Let's rely on main.cpp logic.
-        // If it is subdivision -> treat as non-accent? Or handle logic there?
-        // Let's just modify the callback signature? No, that breaks main.cpp comp.
-        // We will just call it. But wait, main.cpp treats !accent as 'Blue' LED.
-        // We might want a different LED for Sub?
-        // For now, let's treat Subdivision as non-accent.
-        // CHANGE: Do NOT fire haptics/LED for subdivisions, to keep feeling clean.
-        if (!isSubdivision) {
-            _beatCallback(isAccent);
-        }
+    // Report when the click is heard: the command lands in the next chunk
+    // rendered, i.e. at the submitted sample count. If the task is waking
+    // from idle the zeroed DMA ring plays first.
+    // Subdivisions get no haptics/LED, to keep the feeling clean.
+    if (_beatCallback && !isSubdivision) {
+        int64_t heardUs = sampleToMicros(getSampleClock());
+        int64_t earliest = esp_timer_get_time() + getOutputLatencyUs();
+        if (_idle.load(std::memory_order_relaxed) && heardUs < earliest) heardUs = earliest;
+        _beatCallback(isAccent, heardUs);
     }
 }
 
-int16_t AudioEngine::applyLimiter(int32_t sample) {
+// --- Output stages (whole chunk, fixed point) -------------------------------
+// Each stage is a flat loop without data-dependent branches so the compiler
+// can unroll it; per-chunk cost is independent of the signal.
+
+// Master gain in Q31, ramped linearly across the block to avoid zipper noise
+static void stageMasterGain(int32_t* mix, size_t n, int32_t& gainQ31, int32_t targetQ31) {
+    const int32_t step = (targetQ31 - gainQ31) / (int32_t)n;
+    int32_t g = gainQ31;
+    for (size_t i = 0; i < n; i++) {
+        mix[i] = (int32_t)(((int64_t)mix[i] * g) >> 31);
+        g += step;
+    }
+    gainQ31 = targetQ31;
+}
+
+// Soft knee at +-28000 (slope 1/4 above it), then hard clip to int16.
+// Returns non-zero if any sample entered the knee (overdrive).
+static int32_t stageLimiter(const int32_t* in, int16_t* out, size_t n) {
     const int32_t softLimit = 28000;
-    if (sample > softLimit) {
-        _overdrive = true;
-        sample = softLimit + (sample - softLimit) / 4; 
-    } else if (sample < -softLimit) {
-        _overdrive = true;
-        sample = -softLimit + (sample + softLimit) / 4;
+    int32_t overdrive = 0;
+    for (size_t i = 0; i < n; i++) {
+        int32_t x = in[i];
+        int32_t hi = x - softLimit;
+        hi &= ~(hi >> 31);           // max(x - knee, 0)
+        int32_t lo = x + softLimit;
+        lo &= (lo >> 31);            // min(x + knee, 0)
+        x -= (hi - (hi >> 2)) + (lo - (lo >> 2));
+        overdrive |= hi | lo;
+        x = x > 32767 ? 32767 : x;   // Compiles to MIN/MAX, not branches
+        x = x < -32768 ? -32768 : x;
+        out[i] = (int16_t)x;
     }
+    return overdrive;
+}
 
-    if (sample > 32767) sample = 32767;
-    if (sample < -32768) sample = -32768;
-    return (int16_t)sample;
+// Duplicate mono into interleaved L/R with one 32-bit store per frame
+static void stageInterleave(const int16_t* mono, uint32_t* frames, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint32_t s = (uint16_t)mono[i];
+        frames[i] = (s << 16) | s;
+    }
 }
 
-void AudioEngine::audioLoop() {
-    const size_t chunkSamples = 128; // Low latency chunks (approx 3ms)
-    int16_t buffer[chunkSamples * 2]; // Stereo interleaved
+void AudioEngine::renderClickCache() {
+    for (int t = 0; t < CLICK_TYPES; t++) {
+        const ClickTimbre& timbre = kClickTimbres[t];
+        // Render until the envelope falls below -80 dB
+        const float decay = decayAt(timbre, _sampleRate);
+        uint32_t length = (uint32_t)ceilf(logf(0.0001f) / logf(decay));
+
+        ClickSample& click = _clickCache[t];
+        if (click.length != length) {
+            if (click.data) heap_caps_free(click.data);
+            // Internal RAM first (fastest), PSRAM if internal heap is tight
+            click.data = (int16_t*)heap_caps_malloc(length * sizeof(int16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            if (!click.data) click.data = (int16_t*)heap_caps_malloc(length * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+            click.length = click.data ? length : 0;
+        }
+        if (!click.data) continue;
+        renderTimbre(timbre, decay, _sampleRate, click.data, length);
+    }
+}
+
+uint32_t AudioEngine::renderClick(ClickType type, uint32_t sampleRate, int16_t* dst, uint32_t maxLength) const {
+    if (type >= CLICK_TYPES || sampleRate == 0) return 0;
+    const ClickTimbre& timbre = kClickTimbres[type];
+    float decay = decayAt(timbre, sampleRate);
+    uint32_t length = (uint32_t)ceilf(logf(0.0001f) / logf(decay));
+    if (length > maxLength) length = maxLength;
+    renderTimbre(timbre, decay, sampleRate, dst, length);
+    return length;
+}
+
+void AudioEngine::startClick(ClickType type, float gain, uint64_t atSample) {
+    if (type >= CLICK_TYPES) return;
+    const ClickSample& click = _clickCache[type];
+    if (!click.data) return;
+
+    // Every trigger gets its own voice; when the pool is full, steal the one
+    // closest to its end (the quietest tail) instead of cutting the newest.
+    int v = _activeVoices;
+    if (v < AUDIO_MAX_VOICES) {
+        _activeVoices++;
+    } else {
+        uint32_t leastLeft = UINT32_MAX;
+        for (int i = 0; i < AUDIO_MAX_VOICES; i++) {
+            uint32_t left = _voices[i].length - _voices[i].pos;
+            if (left < leastLeft) { leastLeft = left; v = i; }
+        }
+    }
+
+    if (gain < 0.0f) gain = 0.0f;
+    if (gain > 1.0f) gain = 1.0f; // Keeps the Q15 product inside int32
+    ClickVoice& voice = _voices[v];
+    voice.data = click.data;
+    voice.length = click.length;
+    voice.pos = 0;
+    voice.gain = (int32_t)(gain * 32768.0f);
+    recordEmission(type, gain, atSample);
+}
+
+void AudioEngine::recordEmission(ClickType type, float gain, uint64_t atSample) {
+    const ClickTimbre& timbre = kClickTimbres[type];
+    uint32_t n = _emitted.load(std::memory_order_relaxed);
+    ClickEmission& e = _emissions[n & (AUDIO_EMISSION_RING - 1)];
+    e.type = type;
+    e.heardUs = _epochUs + (int64_t)(atSample - _epochSample) * 1000000LL / (int64_t)_sampleRate;
+    e.lengthUs = (uint32_t)((uint64_t)_clickCache[type].length * 1000000ULL / _sampleRate);
+    e.decayUs = (uint32_t)(-1000000.0f / (logf(timbre.decay) * SAMPLE_RATE));
+    // Master gain is vol/100 * 30000/32768 (see the output stages)
+    e.level = gain * _mixVolume * (30000.0f / 32768.0f / 100.0f);
+    _emitted.store(n + 1, std::memory_order_release);
+}
+
+size_t AudioEngine::getRecentClicks(ClickEmission* out, size_t max) const {
+    uint32_t n = _emitted.load(std::memory_order_acquire);
+    size_t count = 0;
+    for (uint32_t i = n; i != n - AUDIO_EMISSION_RING && i != 0 && count < max; i--) {
+        out[count++] = _emissions[(i - 1) & (AUDIO_EMISSION_RING - 1)];
+    }
+    // Drop entries the task reused while they were being copied
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t now = _emitted.load(std::memory_order_relaxed);
+    while (count > 0 && now - (n - count) >= AUDIO_EMISSION_RING) count--;
+    return count;
+}
+
+int AudioEngine::collectCommands(uint64_t chunkEnd, AudioCommand* due) {
+    // Drain every lane once per chunk; commands for later chunks stay queued,
+    // together with whatever their task sent after them (see sendCommand).
+    // Result is ordered by timestamp (insertion sort, the list is tiny).
+    int count = 0;
+    for (int l = 0; l <= AUDIO_CMD_LANES; l++) {
+        AudioCommand cmd;
+        while (count < AUDIO_CMD_PER_CHUNK && _lanes[l].queue.peek(cmd) && cmd.at < chunkEnd) {
+            _lanes[l].queue.pop(cmd);
+            int i = count++;
+            while (i > 0 && due[i - 1].at > cmd.at) {
+                due[i] = due[i - 1];
+                i--;
+            }
+            due[i] = cmd;
+        }
+    }
+    return count;
+}
+
+void AudioEngine::applyCommand(const AudioCommand& cmd, uint64_t atSample) {
+    switch (cmd.type) {
+        case CMD_CLICK:
+            startClick(cmd.click, cmd.value, atSample);
+            break;
+        case CMD_TONE_ON:
+            _toneHz = cmd.value;
+            _toneOsc.setFrequency(_toneHz, _sampleRate);
+            _toneOn = true;
+            break;
+        case CMD_TONE_OFF:
+            _toneOn = false;
+            break;
+        case CMD_VOLUME:
+            _mixVolume = (uint8_t)cmd.value;
+            break;
+    }
+}
+
+void AudioEngine::fireScheduledClick() {
+    if (_clickIndex == 0) {
+        // New beat: latch tempo/meter so changes land on a beat boundary
+        float uiBpm = _bpm;
+        if (uiBpm != _lastUiBpm) {
+            _lastUiBpm = uiBpm; // UI override, a running ramp continues from here
+            _schedBpm = uiBpm;
+        } else if (_rampActive) {
+            float target = _rampTarget;
+            float step = _rampPerBeat;
+            if (_schedBpm < target) {
+                _schedBpm += step;
+                if (_schedBpm >= target) { _schedBpm = target; _rampActive = false; }
+            } else {
+                _schedBpm -= step;
+                if (_schedBpm <= target) { _schedBpm = target; _rampActive = false; }
+            }
+        }
+        _tempoNow = _schedBpm;
+
+        // Exact beat length; double math runs once per beat, not per sample
+        _beatLenQ32 = (uint64_t)(((double)_sampleRate * 60.0 / (double)_schedBpm) * 4294967296.0);
+        _clicksThisBeat = _clicksPerBeat;
+        _beatStart = _nextEvent;
+        _beatStartFrac = _nextEventFrac;
+
+        bool accent = (_beatIndex == 0);
+        startClick(accent ? CLICK_ACCENT : CLICK_NORMAL, 1.0f, _nextEvent);
+
+        int64_t heardUs = _epochUs + (int64_t)(_nextEvent - _epochSample) * 1000000LL / (int64_t)_sampleRate;
+        BeatEvent evt = { _nextEvent, heardUs, (uint8_t)_beatIndex, accent };
+        xQueueSend(_beatQueue, &evt, 0); // Drop if nobody is listening
+
+        _beatIndex++;
+        if (_beatIndex >= _beatsPerBar) _beatIndex = 0;
+    } else {
+        startClick(CLICK_SUB, 0.4f, _nextEvent); // Soft volume for sub
+    }
+
+    // Place every click of the beat relative to the beat start (no rounding build-up)
+    _clickIndex++;
+    if (_clickIndex >= _clicksThisBeat) _clickIndex = 0;
+    uint64_t offset = _clickIndex ? (_beatLenQ32 / _clicksThisBeat) * _clickIndex : _beatLenQ32;
+    _nextEvent = _beatStart;
+    _nextEventFrac = _beatStartFrac;
+    addSamplesQ32(_nextEvent, _nextEventFrac, offset);
+}
+
+// Render kernel specialized at compile time for which sources are sounding,
+// so the inner loops carry no per-sample "is this voice on" tests.
+template <bool kTone, bool kClicks>
+void AudioEngine::renderKernel(size_t from, size_t to) {
+    int32_t* mix = _mixBuf;
+
+    // 1. Tone Synthesis (or silence)
+    if (kTone) {
+        for (size_t i = from; i < to; i++) mix[i] = (_toneOsc.nextQ15() * kToneGainQ15) >> 15;
+    } else {
+        memset(mix + from, 0, (to - from) * sizeof(int32_t));
+    }
+    if (!kClicks) return;
+
+    // 2. Clicks: mix each active voice's cached sample by copy
+    for (int v = 0; v < _activeVoices; v++) {
+        ClickVoice& voice = _voices[v];
+        size_t n = to - from;
+        if (n > voice.length - voice.pos) n = voice.length - voice.pos;
+        const int16_t* src = voice.data + voice.pos;
+        const int32_t gain = voice.gain;
+        int32_t* dst = mix + from;
+        for (size_t i = 0; i < n; i++) dst[i] += (src[i] * gain) >> 15;
+        voice.pos += n;
+
+        if (voice.pos >= voice.length) {
+            // Finished: swap-remove keeps the active range dense
+            _voices[v--] = _voices[--_activeVoices];
+        }
+    }
+}
+
+void AudioEngine::generateVoices(size_t from, size_t to) {
+    if (_toneOn) {
+        if (_activeVoices) renderKernel<true, true>(from, to);
+        else renderKernel<true, false>(from, to);
+    } else {
+        if (_activeVoices) renderKernel<false, true>(from, to);
+        else renderKernel<false, false>(from, to);
+    }
+}
+
+void AudioEngine::publishClock() {
+    AudioClock clock;
+    clock.submitted = _sampleClock;
+    clock.epochSample = _epochSample;
+    clock.epochUs = _epochUs;
+    clock.rate = _sampleRate;
+    clock.lastBeat = 0;
+    clock.nextBeat = 0;
+    if (_schedActive) {
+        if (_clickIndex == 0) {
+            clock.nextBeat = _nextEvent;
+        } else {
+            uint64_t next = _beatStart;
+            uint32_t frac = _beatStartFrac;
+            addSamplesQ32(next, frac, _beatLenQ32);
+            clock.nextBeat = next;
+        }
+        clock.lastBeat = _beatStart; // The first beat fires in the chunk that starts the scheduler
+    }
+
+    _clockSeq.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _clockPublished = clock;
+    _clockSeq.fetch_add(1, std::memory_order_release);
+}
+
+// Writes one chunk and refines the output clock. A write that had to wait
+// returned right as the DMA freed its oldest buffer: the ring is full again
+// and our last frame sits `chunk` frames into the newest buffer, so it is
+// heard (bufCount - 1) * bufLen + chunk frames from now.
+void AudioEngine::submitChunk(const uint32_t* frames, size_t chunkSamples) {
     size_t bytes_written;
+    int64_t t0 = esp_timer_get_time();
+    i2s_write(I2S_NUM_0, frames, chunkSamples * sizeof(uint32_t), &bytes_written, portMAX_DELAY);
+    int64_t t1 = esp_timer_get_time();
 
-    // Synthesis State for Click
-    float clickEnv = 0.0f;
-    float clickPhase = 0.0f;
-    float clickInc = 0.0f;
-    float clickDecay = 0.999f;
-    
-    // Synthesis State for Tone
-    float tonePhase = 0.0f;
+    if (t1 - t0 > AUDIO_BLOCKED_WRITE_US) {
+        const AudioProfile& profile = kAudioProfiles[_activeProfile];
+        const uint32_t ahead = (uint32_t)(profile.dmaBufCount - 1) * profile.dmaBufLen + chunkSamples;
+        const int64_t measured = t1 + (int64_t)ahead * 1000000LL / _sampleRate;
+        const int64_t predicted = _epochUs + (int64_t)(_sampleClock - _epochSample) * 1000000LL / _sampleRate;
+        // A late wake-up only ever makes the measurement later, so trust
+        // early readings outright and follow late ones (crystal drift) slowly
+        if (!_epochLocked || measured < predicted) _epochUs = measured;
+        else _epochUs = predicted + (measured - predicted) / 32;
+        _epochSample = _sampleClock;
+        _epochLocked = true;
+    }
+    publishClock();
+}
+
+void AudioEngine::audioLoop() {
+    uint32_t buffer[AUDIO_MAX_CHUNK_SAMPLES]; // Stereo interleaved (L/R int16 pairs)
+    static const uint32_t silence[AUDIO_MAX_CHUNK_SAMPLES] = { 0 };
+    uint32_t silentChunks = 0;
+    AudioCommand due[AUDIO_CMD_PER_CHUNK];
 
     while (true) {
-        // --- Event Handling ---
-        if (_triggerClick) {
-            _triggerClick = false;
-            // "Woodblock" Synthesis
-            // High frequency sine with exponential decay
-            float freq;
-            if (_triggerClickSub) {
-                freq = 2000.0f; // Higher/Thinner for sub
-                clickDecay = 0.995f; // Faster decay (shorter tick)
-            } else {
-                freq = _triggerClickAccent ? 2500.0f : 1600.0f;
-                // Fast decay for percussive sound
-                // 0.9985 ^ 2000 samples (~45ms) -> ~0.05 amplitude
-                clickDecay = 0.9985f; 
+        const AudioProfile& profile = kAudioProfiles[_activeProfile];
+        const size_t chunkSamples = profile.chunkSamples;
+        const uint32_t flushChunks = ((uint32_t)profile.dmaBufCount * profile.dmaBufLen) / chunkSamples;
+
+        // --- Idle ---
+        // Nothing sounding or pending and the DMA ring already flushed with
+        // zeros: stop I2S TX and sleep until a command or start arrives.
+        if (silentChunks >= flushChunks && !hasPendingWork()) {
+            _idle.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!hasPendingWork()) {
+                i2s_stop(I2S_NUM_0);
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                i2s_zero_dma_buffer(I2S_NUM_0);
+                i2s_start(I2S_NUM_0);
+                resetEpoch();
             }
-            clickInc = (2.0f * PI * freq) / SAMPLE_RATE;
-            
-            clickPhase = 0.0f;
-            clickEnv = _triggerClickSub ? 0.4f : 1.0f; // Soft volume for sub
+            _idle.store(false, std::memory_order_relaxed);
+            silentChunks = 0;
+        }
+
+        // --- Profile Switch ---
+        if (_requestedProfile != _activeProfile) {
+            applyProfile(_requestedProfile);
+            silentChunks = 0;
+            continue; // Re-read chunk geometry
         }
 
+        const uint64_t chunkEnd = _sampleClock + chunkSamples;
+#ifdef AUDIO_BENCHMARK
+        uint32_t cycStart = ESP.getCycleCount();
+#endif
+
+        // --- Event Handling ---
+        int dueCount = collectCommands(chunkEnd, due);
+        int nextCmd = 0;
+
+        // --- Beat Scheduler ---
+        // The audio task owns the beat clock: clicks start at their exact
+        // sample offset inside the chunk instead of at the chunk boundary.
+        if (_metroRestart) {
+            _metroRestart = false;
+            _schedActive = true;
+            _nextEvent = _sampleClock;
+            _nextEventFrac = 0;
+            _lastUiBpm = _bpm;
+            _schedBpm = _lastUiBpm;
+            _clickIndex = 0;
+            _beatIndex = 0;
+        }
+        if (!_metroRunning) _schedActive = false;
+
+        // --- Silence Fast-Path ---
+        // No source sounding and no event inside this chunk: skip synthesis
+        // and submit the pre-zeroed buffer.
+        if (!_toneOn && _activeVoices == 0 && dueCount == 0 && !(_schedActive && _nextEvent < chunkEnd)) {
+            _gainQ31 = (int32_t)_mixVolume * 19660800; // No ramp needed over silence
+            _sampleClock = chunkEnd;
+            silentChunks++;
+            submitChunk(silence, chunkSamples);
+            continue;
+        }
+        silentChunks = 0;
+
         // --- Synthesis ---
-        float vol = (float)_volume / 100.0f;
-        float toneInc = (2.0f * PI * _toneFreq) / SAMPLE_RATE;
-        bool toneOn = _isTonePlaying;
-
-        for (int i = 0; i < chunkSamples; i++) {
-            float mix = 0.0f;
-
-            // 1. Click Synthesis
-            if (clickEnv > 0.0001f) {
-                // Initial burst of noise for "attack"? 
-                // Simple sine burst is usually clean enough for metronome.
-                mix += sin(clickPhase) * clickEnv;
-                clickPhase += clickInc;
-                if (clickPhase > 2.0f * PI) clickPhase -= 2.0f * PI;
-                clickEnv *= clickDecay;
+        // Render up to each event (scheduled beat or queued command), apply it, continue
+        size_t pos = 0;
+        while (true) {
+            uint64_t at = chunkEnd;
+            bool isBeat = false;
+            if (_schedActive && _nextEvent < at) {
+                at = _nextEvent;
+                isBeat = true;
+            }
+            if (nextCmd < dueCount && due[nextCmd].at <= at) {
+                at = due[nextCmd].at; // Commands win ties so volume/tone apply first
+                isBeat = false;
             }
+            if (at >= chunkEnd) break;
 
-            // 2. Tone Synthesis
-            if (toneOn) {
-                mix += sin(tonePhase) * 0.7f; // continuous tone lower gain
-                tonePhase += toneInc;
-                if (tonePhase > 2.0f * PI) tonePhase -= 2.0f * PI;
+            size_t offset = (at > _sampleClock) ? (size_t)(at - _sampleClock) : 0;
+            if (offset > pos) {
+                generateVoices(pos, offset);
+                pos = offset;
             }
+            if (isBeat) fireScheduledClick();
+            else applyCommand(due[nextCmd++], _sampleClock + pos);
+        }
+        generateVoices(pos, chunkSamples);
 
-            // 3. Master Volume & Limiter
-            // Scale to int16 range (approx 30000 to leave headroom)
-            int32_t s = (int32_t)(mix * 30000.0f * vol);
-            int16_t finalSample = applyLimiter(s);
+        // --- Output Stages ---
+        // Scale to int16 range (approx 30000 at full volume to leave headroom):
+        // vol/100 * 30000/32768 in Q31
+        const int32_t targetGain = (int32_t)_mixVolume * 19660800;
+        stageMasterGain(_mixBuf, chunkSamples, _gainQ31, targetGain);
+        if (stageLimiter(_mixBuf, _monoBuf, chunkSamples)) _overdrive = true;
+        stageInterleave(_monoBuf, buffer, chunkSamples);
 
-            // Stereo Copy
-            buffer[i * 2] = finalSample;
-            buffer[i * 2 + 1] = finalSample;
-        }
+        _sampleClock = chunkEnd;
+#ifdef AUDIO_BENCHMARK
+        // Exponential average over ~16 chunks
+        uint32_t cyc = ESP.getCycleCount() - cycStart;
+        _renderCycles = _renderCycles - (_renderCycles >> 4) + (cyc >> 4);
+#endif
 
         // --- Output ---
         // Write to I2S DMA buffer (will block if buffer is full, regulating speed)
-        i2s_write(I2S_NUM_0, buffer, sizeof(buffer), &bytes_written, portMAX_DELAY);
+        submitChunk(buffer, chunkSamples);
     }
 }
@@ -0,0 +1,111 @@
+#include "FeedbackDriver.h"
+#include <driver/ledc.h>
+
+void FeedbackDriver::begin(LedRing* ring) {
+    _ring = ring;
+
+    // Haptic PWM init (LEDC Legacy API for Core 2.0.x)
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .duty_resolution = LEDC_TIMER_10_BIT,
+        .timer_num = LEDC_TIMER_0,
+        .freq_hz = HAPTIC_PWM_FREQ,
+        .clk_cfg = LEDC_AUTO_CLK
+    };
+    ledc_timer_config(&ledc_timer);
+
+    ledc_channel_config_t ledc_channel = {
+        .gpio_num = HAPTIC_PIN,
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .channel = (ledc_channel_t)HAPTIC_PWM_CH,
+        .intr_type = LEDC_INTR_DISABLE,
+        .timer_sel = LEDC_TIMER_0,
+        .duty = 0,
+        .hpoint = 0
+    };
+    ledc_channel_config(&ledc_channel);
+
+    esp_timer_create_args_t onArgs = {};
+    onArgs.callback = &FeedbackDriver::onTimerCb;
+    onArgs.arg = this;
+    onArgs.dispatch_method = ESP_TIMER_TASK;
+    onArgs.name = "fb_on";
+    esp_timer_create(&onArgs, &_onTimer);
+
+    esp_timer_create_args_t offArgs = onArgs;
+    offArgs.callback = &FeedbackDriver::offTimerCb;
+    offArgs.name = "fb_off";
+    esp_timer_create(&offArgs, &_offTimer);
+
+    _queue = xQueueCreate(FEEDBACK_QUEUE_LEN, sizeof(FeedbackPulse));
+
+    xTaskCreatePinnedToCore(
+        FeedbackDriver::taskEntry,
+        "FeedbackTask",
+        2048,
+        this,
+        FEEDBACK_TASK_PRIO,
+        &_taskHandle,
+        FEEDBACK_TASK_CORE
+    );
+}
+
+bool FeedbackDriver::schedule(const FeedbackPulse& pulse) {
+    if (!_queue) return false;
+    return xQueueSend(_queue, &pulse, 0) == pdTRUE;
+}
+
+void FeedbackDriver::taskEntry(void* param) {
+    FeedbackDriver* instance = static_cast<FeedbackDriver*>(param);
+    instance->feedbackLoop();
+    vTaskDelete(NULL);
+}
+
+void FeedbackDriver::feedbackLoop() {
+    FeedbackPulse pulse;
+    while (true) {
+        xQueueReceive(_queue, &pulse, portMAX_DELAY);
+
+        // Drop pulses that would already be over
+        int64_t wait = pulse.startUs - esp_timer_get_time();
+        if (wait + (int64_t)pulse.durationUs <= 0) continue;
+
+        _current = pulse;
+        if (wait > 0) esp_timer_start_once(_onTimer, (uint64_t)wait);
+        else onTimerCb(this);
+
+        // The off timer notifies us; the timeout only guards against a lost edge
+        uint32_t guardMs = (uint32_t)((wait > 0 ? wait : 0) + pulse.durationUs) / 1000 + 50;
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(guardMs)) == 0) {
+            esp_timer_stop(_onTimer);
+            esp_timer_stop(_offTimer);
+            pulseOff();
+        }
+    }
+}
+
+void FeedbackDriver::onTimerCb(void* param) {
+    FeedbackDriver* self = static_cast<FeedbackDriver*>(param);
+    self->pulseOn();
+    esp_timer_start_once(self->_offTimer, self->_current.durationUs);
+}
+
+void FeedbackDriver::offTimerCb(void* param) {
+    FeedbackDriver* self = static_cast<FeedbackDriver*>(param);
+    self->pulseOff();
+    xTaskNotifyGive(self->_taskHandle);
+}
+
+void FeedbackDriver::pulseOn() {
+    if (_current.duty) {
+        ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)HAPTIC_PWM_CH, _current.duty);
+        ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)HAPTIC_PWM_CH);
+    }
+    if (_current.ledFrame != LED_FRAME_NONE && _ring) _ring->show(_current.ledFrame);
+}
+
+void FeedbackDriver::pulseOff() {
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)HAPTIC_PWM_CH, 0);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)HAPTIC_PWM_CH);
+    if (_current.ledFrame != LED_FRAME_NONE && _ring) _ring->clear();
+}
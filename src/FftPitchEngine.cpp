@@ -0,0 +1,45 @@
+#include "FftPitchEngine.h"
+
+float FftPitchEngine::detect(float* frame, float sampleRate) {
+    // Float, real input, in place
+    _fft.applyWindow(frame);
+    memcpy(_windowed, frame, sizeof(_windowed));
+    _fft.forward(frame);
+    RealFFT<FFT_SAMPLES>::power(frame);
+    float coarse = RealFFT<FFT_SAMPLES>::peakFrequency(frame, sampleRate);
+    if (coarse <= 0.0f) return 0.0f;
+    return zoom(coarse, sampleRate);
+}
+
+// Direct chirp-z: the DTFT of the windowed frame on an arc of
+// FFT_ZOOM_POINTS frequencies, each evaluated with a Goertzel recurrence
+// (one multiply-add per sample and point, far below a Bluestein transform
+// at this size)
+float FftPitchEngine::zoom(float coarse, float sampleRate) const {
+    const float bin = sampleRate / FFT_SAMPLES;
+    const float step = FFT_ZOOM_SPAN * bin / (FFT_ZOOM_POINTS - 1);
+    const float first = coarse - 0.5f * FFT_ZOOM_SPAN * bin;
+
+    float mag[FFT_ZOOM_POINTS];
+    int best = 0;
+    for (int k = 0; k < FFT_ZOOM_POINTS; k++) {
+        float coeff = 2.0f * cosf(2.0f * PI * (first + k * step) / sampleRate);
+        float s1 = 0.0f, s2 = 0.0f;
+        for (int i = 0; i < FFT_SAMPLES; i++) {
+            float s = _windowed[i] + coeff * s1 - s2;
+            s2 = s1;
+            s1 = s;
+        }
+        float p = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+        mag[k] = sqrtf(p > 0.0f ? p : 0.0f);
+        if (mag[k] > mag[best]) best = k;
+    }
+
+    // Peak at the edge of the band: the coarse estimate was off by more
+    // than a bin, keep the grid point
+    if (best == 0 || best == FFT_ZOOM_POINTS - 1) return first + best * step;
+    float a = mag[best - 1], b = mag[best], c = mag[best + 1];
+    float denom = a - 2.0f * b + c;
+    float delta = (denom != 0.0f) ? 0.5f * (a - c) / denom : 0.0f;
+    return first + (best + delta) * step;
+}
@@ -0,0 +1,224 @@
+#include "LatencyCalibrator.h"
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+
+static const uint32_t kCaptureSamples = CALIB_SEARCH_SAMPLES + CALIB_REF_SAMPLES;
+
+// Reference: the chirp as the speaker plays it, at the mic rate. Its
+// duration is the same in every output profile, so it is rendered once.
+void LatencyCalibrator::begin(AudioEngine* audio, MicStream* mic) {
+    _audio = audio;
+    _mic = mic;
+    uint32_t length = _audio->renderClick(CLICK_CHIRP, MIC_SAMPLE_RATE, _ref, CALIB_REF_SAMPLES);
+    _refEnergy = 0.0f;
+    for (uint32_t i = 0; i < CALIB_REF_SAMPLES; i++) {
+        if (i >= length) _ref[i] = 0;
+        _refEnergy += (float)_ref[i] * (float)_ref[i];
+    }
+}
+
+void LatencyCalibrator::start() {
+    if (!_audio || !_mic) return;
+
+    release();
+    _capture = (int32_t*)heap_caps_malloc(kCaptureSamples * sizeof(int32_t), MALLOC_CAP_8BIT);
+    _signal = (float*)heap_caps_malloc(kCaptureSamples * sizeof(float), MALLOC_CAP_8BIT);
+    if (!_capture || !_signal) {
+        fail("Out of memory");
+        return;
+    }
+
+    _burst = 0;
+    _good = 0;
+    _error = "";
+    _state = CALIB_RUNNING;
+    _phase = PHASE_WAIT;
+    _phaseStart = millis();
+    _waitMs = CALIB_SETTLE_MS;
+}
+
+void LatencyCalibrator::cancel() {
+    release();
+    _state = CALIB_IDLE;
+}
+
+void LatencyCalibrator::release() {
+    if (_capture) heap_caps_free(_capture);
+    if (_signal) heap_caps_free(_signal);
+    _capture = nullptr;
+    _signal = nullptr;
+}
+
+void LatencyCalibrator::fail(const char* error) {
+    release();
+    _error = error;
+    _state = CALIB_FAILED;
+}
+
+// Median of the bursts that correlated
+void LatencyCalibrator::finish() {
+    release();
+    if (_good < CALIB_MIN_GOOD) {
+        fail("Chirp not heard");
+        return;
+    }
+    for (int i = 1; i < _good; i++) {
+        int32_t v = _results[i];
+        int j = i - 1;
+        while (j >= 0 && _results[j] > v) {
+            _results[j + 1] = _results[j];
+            j--;
+        }
+        _results[j + 1] = v;
+    }
+    _latencyUs = (_good & 1) ? _results[_good / 2]
+                             : (_results[_good / 2 - 1] + _results[_good / 2]) / 2;
+    _state = CALIB_DONE;
+}
+
+// Mic stream index of the sample captured at esp_timer time us
+uint32_t LatencyCalibrator::micIndexAt(int64_t us) const {
+    uint32_t ref = _mic->written() - 1;
+    int64_t dt = us - _mic->sampleToMicros(ref);
+    return ref + (uint32_t)(int32_t)(dt * MIC_SAMPLE_RATE / 1000000LL);
+}
+
+bool LatencyCalibrator::update() {
+    if (_state != CALIB_RUNNING) return false;
+    unsigned long now = millis();
+
+    switch (_phase) {
+        case PHASE_WAIT:
+            if (now - _phaseStart < _waitMs) return false;
+            _phase = PHASE_PLAY;
+            // Fall through
+
+        case PHASE_PLAY:
+            if (_audio->getVolume() == 0) {
+                fail("Volume is 0");
+                return false;
+            }
+            _sentUs = esp_timer_get_time();
+            if (!_audio->scheduleClick(CLICK_CHIRP, 1.0f)) return false; // Queue full: next call
+            _phase = PHASE_WAIT_OUTPUT;
+            _phaseStart = now;
+            return false;
+
+        case PHASE_WAIT_OUTPUT: {
+            // The audio task records when the chirp reaches the DAC
+            ClickEmission clicks[AUDIO_EMISSION_RING];
+            size_t n = _audio->getRecentClicks(clicks, AUDIO_EMISSION_RING);
+            for (size_t i = 0; i < n; i++) {
+                if (clicks[i].type != CLICK_CHIRP || clicks[i].heardUs <= _sentUs) continue;
+                _heardUs = clicks[i].heardUs;
+                _captureFrom = micIndexAt(_heardUs - CALIB_PRE_US);
+                _phase = PHASE_WAIT_CAPTURE;
+                _phaseStart = now;
+                return false;
+            }
+            if (now - _phaseStart > CALIB_TIMEOUT_MS) fail("No audio output");
+            return false;
+        }
+
+        case PHASE_WAIT_CAPTURE: {
+            if ((int32_t)(_mic->written() - (_captureFrom + kCaptureSamples)) < 0) {
+                if (now - _phaseStart > CALIB_TIMEOUT_MS) fail("Mic not running");
+                return false;
+            }
+            if (!_mic->copy(_captureFrom, _capture, kCaptureSamples)) {
+                nextBurst(now); // Overwritten before we got to it
+                return _state == CALIB_DONE;
+            }
+            prepare();
+            _phase = PHASE_ANALYZE;
+            return false;
+        }
+
+        case PHASE_ANALYZE: {
+            if (!scan()) return false;
+            int32_t latencyUs;
+            if (measure(latencyUs)) _results[_good++] = latencyUs;
+            nextBurst(now);
+            return _state == CALIB_DONE;
+        }
+    }
+    return false;
+}
+
+void LatencyCalibrator::nextBurst(unsigned long now) {
+    if (++_burst >= CALIB_BURSTS) {
+        finish();
+        return;
+    }
+    _phase = PHASE_WAIT;
+    _phaseStart = now;
+    _waitMs = CALIB_GAP_MS;
+}
+
+float LatencyCalibrator::correlate(uint32_t lag) const {
+    float dot = 0.0f;
+    for (uint32_t i = 0; i < CALIB_REF_SAMPLES; i++) dot += (float)_ref[i] * _signal[lag + i];
+    return dot;
+}
+
+// Finds the chirp in the capture: normalised cross-correlation over every
+// lag (the sign is ignored, amps may invert), parabolic sub-sample peak.
+// prepare() sets up the burst, scan() covers CALIB_LAGS_PER_UPDATE lags
+// per call, measure() turns the best lag into a latency.
+void LatencyCalibrator::prepare() {
+    float mean = 0.0f;
+    for (uint32_t i = 0; i < kCaptureSamples; i++) {
+        _signal[i] = (float)(_capture[i] >> 14);
+        mean += _signal[i];
+    }
+    mean /= kCaptureSamples;
+    for (uint32_t i = 0; i < kCaptureSamples; i++) _signal[i] -= mean;
+
+    _energy = 0.0f;
+    for (uint32_t i = 0; i < CALIB_REF_SAMPLES; i++) _energy += _signal[i] * _signal[i];
+    _lag = 0;
+    _best = 0.0f;
+    _bestLag = 0;
+}
+
+// True once every lag has been tried
+bool LatencyCalibrator::scan() {
+    uint32_t end = _lag + CALIB_LAGS_PER_UPDATE;
+    if (end > CALIB_SEARCH_SAMPLES) end = CALIB_SEARCH_SAMPLES;
+    for (; _lag < end; _lag++) {
+        float norm = _refEnergy * _energy;
+        if (norm > 0.0f) {
+            float r = correlate(_lag) / sqrtf(norm);
+            if (fabsf(r) > fabsf(_best)) {
+                _best = r;
+                _bestLag = _lag;
+            }
+        }
+        float in = _signal[_lag + CALIB_REF_SAMPLES];
+        float out = _signal[_lag];
+        _energy += in * in - out * out;
+        if (_energy < 0.0f) _energy = 0.0f;
+    }
+    return _lag >= CALIB_SEARCH_SAMPLES;
+}
+
+bool LatencyCalibrator::measure(int32_t& latencyUs) const {
+    const float best = _best;
+    const uint32_t bestLag = _bestLag;
+    if (fabsf(best) < CALIB_MIN_CORR) return false;
+
+    float frac = 0.0f;
+    if (bestLag > 0 && bestLag < CALIB_SEARCH_SAMPLES - 1) {
+        float sign = (best < 0.0f) ? -1.0f : 1.0f;
+        float a = sign * correlate(bestLag - 1);
+        float b = sign * correlate(bestLag);
+        float c = sign * correlate(bestLag + 1);
+        float d = a - 2.0f * b + c;
+        if (d < 0.0f) frac = 0.5f * (a - c) / d;
+    }
+
+    int64_t arrivalUs = _mic->sampleToMicros(_captureFrom) +
+                        (int64_t)lrintf(((float)bestLag + frac) * (1000000.0f / MIC_SAMPLE_RATE));
+    latencyUs = (int32_t)(arrivalUs - _heardUs);
+    return true;
+}
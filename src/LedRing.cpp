@@ -0,0 +1,100 @@
+#include "LedRing.h"
+
+// WS2812 bit timings in RMT ticks, set in begin() from the channel clock
+static uint32_t t0h, t0l, t1h, t1l;
+
+void LedRing::begin() {
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t)WS2812_PIN, (rmt_channel_t)LED_RMT_CHANNEL);
+    config.clk_div = 2; // 40 MHz: 25 ns ticks
+    rmt_config(&config);
+    rmt_driver_install(config.channel, 0, 0);
+
+    uint32_t clockHz;
+    rmt_get_counter_clock(config.channel, &clockHz);
+    const float ticksPerNs = clockHz / 1e9f;
+    t0h = (uint32_t)(400 * ticksPerNs);
+    t0l = (uint32_t)(850 * ticksPerNs);
+    t1h = (uint32_t)(800 * ticksPerNs);
+    t1l = (uint32_t)(450 * ticksPerNs);
+    rmt_translator_init(config.channel, LedRing::translate);
+
+    _beats = 0; // Force the first layout
+    setBeatsPerBar(4);
+    _initialized = true;
+    clear();
+}
+
+// Runs in the RMT ISR: expands frame bytes into bit pulses as the channel
+// memory drains, so no RMT item buffer has to be kept per frame
+void IRAM_ATTR LedRing::translate(const void* src, rmt_item32_t* dest, size_t srcSize,
+                                  size_t wanted, size_t* translated, size_t* itemNum) {
+    rmt_item32_t bit0, bit1;
+    bit0.duration0 = t0h; bit0.level0 = 1; bit0.duration1 = t0l; bit0.level1 = 0;
+    bit1.duration0 = t1h; bit1.level0 = 1; bit1.duration1 = t1l; bit1.level1 = 0;
+    const uint8_t* psrc = (const uint8_t*)src;
+    size_t size = 0;
+    size_t num = 0;
+    while (size < srcSize && num + 8 <= wanted) {
+        for (int i = 7; i >= 0; i--) {
+            dest->val = (psrc[size] & (1 << i)) ? bit1.val : bit0.val;
+            dest++;
+        }
+        num += 8;
+        size++;
+    }
+    *translated = size;
+    *itemNum = num;
+}
+
+void LedRing::setPixel(uint8_t* frame, int led, uint8_t r, uint8_t g, uint8_t b) {
+    // Brightness is baked in when frames are built, not per show()
+    frame[led * 3 + 0] = (g * LED_BRIGHTNESS) >> 8;
+    frame[led * 3 + 1] = (r * LED_BRIGHTNESS) >> 8;
+    frame[led * 3 + 2] = (b * LED_BRIGHTNESS) >> 8;
+}
+
+void LedRing::buildFrames(uint8_t* bank, int beats) {
+    memset(bank, 0, LED_FRAME_COUNT * LED_FRAME_BYTES);
+
+    for (int i = 0; i < WS2812_NUM_LEDS; i++) {
+        setPixel(bank + LED_FRAME_FLASH_ACCENT * LED_FRAME_BYTES, i, 255, 0, 0); // Red
+        setPixel(bank + LED_FRAME_FLASH * LED_FRAME_BYTES, i, 0, 0, 255);        // Blue
+    }
+
+    // Beat k lights its segment of the ring; other segments show a dim
+    // marker on their first pixel so the bar layout stays readable
+    for (int k = 0; k < beats; k++) {
+        uint8_t* frame = bank + (LED_FRAME_BEAT0 + k) * LED_FRAME_BYTES;
+        for (int s = 0; s < beats; s++) {
+            int first = s * WS2812_NUM_LEDS / beats;
+            int last = (s + 1) * WS2812_NUM_LEDS / beats;
+            if (s == k) {
+                for (int i = first; i < last; i++) {
+                    if (k == 0) setPixel(frame, i, 255, 0, 0); // Red
+                    else setPixel(frame, i, 0, 0, 255);        // Blue
+                }
+            } else if (first < last) {
+                setPixel(frame, first, 16, 16, 16);
+            }
+        }
+    }
+}
+
+void LedRing::setBeatsPerBar(int beats) {
+    if (beats < 1) beats = 1;
+    if (beats > LED_MAX_BEATS) beats = LED_MAX_BEATS;
+    if (beats == _beats) return;
+
+    uint8_t next = _activeBank.load(std::memory_order_relaxed) ^ 1;
+    buildFrames(&_frames[next][0][0], beats);
+    _beats = beats;
+    _activeBank.store(next, std::memory_order_release);
+}
+
+bool LedRing::show(uint8_t frame) {
+    if (!_initialized || frame >= LED_FRAME_COUNT) return false;
+    const rmt_channel_t channel = (rmt_channel_t)LED_RMT_CHANNEL;
+    if (rmt_wait_tx_done(channel, 0) != ESP_OK) return false; // Never wait on the wire
+    const uint8_t* data = _frames[_activeBank.load(std::memory_order_acquire)][frame];
+    return rmt_write_sample(channel, data, LED_FRAME_BYTES, false) == ESP_OK;
+}
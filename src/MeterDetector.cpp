@@ -0,0 +1,155 @@
+#include "MeterDetector.h"
+
+void MeterDetector::reset() {
+    _current = MeterResult();
+    _pending = MeterResult();
+    _pendingCount = 0;
+}
+
+// 1-D 2-means on the peak levels. strength[i] is the tap's position
+// between the two cluster centres (0 = normal, 1 = accent). False if the
+// clusters are too close to call anything an accent.
+bool MeterDetector::cluster(const float* peaks, int n, float* strength, bool* accents) {
+    float lo = peaks[0], hi = peaks[0];
+    for (int i = 1; i < n; i++) {
+        if (peaks[i] < lo) lo = peaks[i];
+        if (peaks[i] > hi) hi = peaks[i];
+    }
+    for (int iter = 0; iter < 8; iter++) {
+        float mid = (lo + hi) * 0.5f;
+        float sumLo = 0, sumHi = 0;
+        int nLo = 0, nHi = 0;
+        for (int i = 0; i < n; i++) {
+            if (peaks[i] > mid) { sumHi += peaks[i]; nHi++; }
+            else { sumLo += peaks[i]; nLo++; }
+        }
+        if (nLo == 0 || nHi == 0) break;
+        float newLo = sumLo / nLo;
+        float newHi = sumHi / nHi;
+        if (newLo == lo && newHi == hi) break;
+        lo = newLo;
+        hi = newHi;
+    }
+
+    bool separated = hi > 0.0f && (hi - lo) / hi >= METER_MIN_SEPARATION;
+    float mid = (lo + hi) * 0.5f;
+    for (int i = 0; i < n; i++) {
+        accents[i] = separated && peaks[i] > mid;
+        float s = separated ? (peaks[i] - lo) / (hi - lo) : 0.0f;
+        strength[i] = s < 0.0f ? 0.0f : (s > 1.0f ? 1.0f : s);
+    }
+    return separated;
+}
+
+bool MeterDetector::sameMeter(const MeterResult& a, const MeterResult& b) {
+    if (a.beats != b.beats || a.groupCount != b.groupCount) return false;
+    for (int g = 0; g < a.groupCount; g++) {
+        if (a.groups[g] != b.groups[g]) return false;
+    }
+    return true;
+}
+
+bool MeterDetector::analyze(const float* peaks, int n, uint32_t firstIndex, bool* accents, MeterResult& out) {
+    out = _current;
+    if (n > METER_MAX_TAPS) {
+        // Keep the newest taps
+        accents += n - METER_MAX_TAPS;
+        peaks += n - METER_MAX_TAPS;
+        firstIndex += n - METER_MAX_TAPS;
+        n = METER_MAX_TAPS;
+    }
+    float x[METER_MAX_TAPS];
+    if (n < 2 * METER_MIN_BEATS || !cluster(peaks, n, x, accents)) return false;
+
+    // Agreement of the accent pattern with itself shifted by `lag`
+    // (1 = identical, 0.5 = unrelated for a balanced pattern)
+    float score[METER_MAX_BEATS + 1];
+    for (int lag = 1; lag <= METER_MAX_BEATS && lag < n; lag++) {
+        float agree = 0.0f;
+        for (int i = lag; i < n; i++) {
+            agree += x[i] * x[i - lag] + (1.0f - x[i]) * (1.0f - x[i - lag]);
+        }
+        score[lag] = agree / (n - lag);
+    }
+
+    // Shortest bar that (nearly) matches the best score: multiples of the
+    // true bar score just as well and must not win
+    int maxLag = n / 2; // Need at least one full repetition
+    if (maxLag > METER_MAX_BEATS) maxLag = METER_MAX_BEATS;
+    if (maxLag < METER_MIN_BEATS) return false;
+    float best = 0.0f;
+    for (int lag = METER_MIN_BEATS; lag <= maxLag; lag++) {
+        if (score[lag] > best) best = score[lag];
+    }
+    int beats = 0;
+    for (int lag = METER_MIN_BEATS; lag <= maxLag; lag++) {
+        if (score[lag] >= best - 0.05f) { beats = lag; break; }
+    }
+
+    // Confidence: how far the bar stands out from the tap-to-tap baseline
+    float baseline = score[1];
+    float confidence = (baseline < 1.0f) ? (score[beats] - baseline) / (1.0f - baseline) : 0.0f;
+    if (confidence < 0.0f) confidence = 0.0f;
+    if (confidence < METER_MIN_CONFIDENCE) return false;
+
+    // Accent strength per position in the bar; downbeat = strongest accent.
+    // Positions count from the first tap of the sequence, not from the
+    // oldest tap in the window, so they don't rotate once the window slides.
+    float phaseSum[METER_MAX_BEATS] = { 0 };
+    float phasePeak[METER_MAX_BEATS] = { 0 };
+    int phaseCount[METER_MAX_BEATS] = { 0 };
+    for (int i = 0; i < n; i++) {
+        int p = (int)((firstIndex + i) % beats);
+        phaseSum[p] += x[i];
+        phasePeak[p] += peaks[i];
+        phaseCount[p]++;
+    }
+    // The downbeat is the accented position with the clearly loudest peaks
+    // (more than 10% above the others). With equal group accents it is the
+    // first accented position of the bar that started the sequence.
+    int downbeat = -1;
+    float downbeatPeak = 0.0f;
+    bool accented[METER_MAX_BEATS];
+    for (int p = 0; p < beats; p++) {
+        accented[p] = phaseSum[p] > 0.5f * phaseCount[p];
+        float level = phasePeak[p] / phaseCount[p];
+        if (accented[p] && (downbeat < 0 || level > downbeatPeak * 1.1f)) {
+            downbeat = p;
+            downbeatPeak = level;
+        }
+    }
+    if (downbeat < 0) return false;
+
+    // Grouping: distances between accented positions, starting at the downbeat
+    MeterResult result = {};
+    result.beats = beats;
+    result.confidence = confidence;
+    int len = 1;
+    for (int k = 1; k <= beats; k++) {
+        int p = (downbeat + k) % beats;
+        if (k == beats || accented[p]) {
+            if (result.groupCount == METER_MAX_GROUPS) return false;
+            result.groups[result.groupCount++] = len;
+            len = 1;
+        } else {
+            len++;
+        }
+    }
+
+    // Hysteresis: a different meter has to win twice in a row
+    if (sameMeter(result, _current)) {
+        _current.confidence = confidence;
+        _pendingCount = 0;
+        out = _current;
+        return false;
+    }
+    if (_current.beats > 0) {
+        if (sameMeter(result, _pending)) _pendingCount++;
+        else { _pending = result; _pendingCount = 1; }
+        if (_pendingCount < 2) return false;
+    }
+    _current = result;
+    _pendingCount = 0;
+    out = _current;
+    return true;
+}
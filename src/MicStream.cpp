@@ -0,0 +1,171 @@
+#include "MicStream.h"
+#include <esp_timer.h>
+
+void MicStream::begin() {
+    if (_taskHandle) return;
+
+    i2s_config_t i2s_config = {
+        .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX),
+        .sample_rate = MIC_SAMPLE_RATE,
+        .bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT, // INMP441 uses 32-bit slots (24-bit data)
+        .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT, // Or RIGHT depending on connection. ONLY_LEFT is standard for mono INMP441
+        .communication_format = I2S_COMM_FORMAT_STAND_I2S,
+        .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
+        .dma_buf_count = 4,
+        .dma_buf_len = MIC_DMA_LEN
+    };
+
+    i2s_pin_config_t pin_config = {
+        .bck_io_num = I2S_MIC_SCK,
+        .ws_io_num = I2S_MIC_WS,
+        .data_out_num = -1,
+        .data_in_num = I2S_MIC_SD
+    };
+
+    // Use I2S_NUM_1 for Input (Output is on NUM_0)
+    i2s_driver_install(I2S_NUM_1, &i2s_config, 0, NULL);
+    i2s_set_pin(I2S_NUM_1, &pin_config);
+    i2s_stop(I2S_NUM_1);
+    _paused = true;
+
+    xTaskCreatePinnedToCore(
+        MicStream::taskEntry,
+        "MicTask",
+        3072,
+        this,
+        MIC_TASK_PRIO,
+        &_taskHandle,
+        MIC_TASK_CORE
+    );
+}
+
+bool MicStream::addListener(MicBlockCallback cb, void* ctx) {
+    if (_listenerCount >= MIC_MAX_LISTENERS) return false;
+    _listeners[_listenerCount].cb = cb;
+    _listeners[_listenerCount].ctx = ctx;
+    _listenerCount++;
+    return true;
+}
+
+void MicStream::pause() {
+    if (_paused) return;
+    _paused = true;
+    i2s_stop(I2S_NUM_1); // A pending read times out and the task parks
+}
+
+void MicStream::resume() {
+    if (!_paused || !_taskHandle) return;
+    // Readers skip everything before the gap
+    _resumeIndex = written();
+    _paused = false;
+    i2s_start(I2S_NUM_1);
+    xTaskNotifyGive(_taskHandle);
+}
+
+void MicStream::taskEntry(void* param) {
+    MicStream* instance = static_cast<MicStream*>(param);
+    instance->captureLoop();
+    vTaskDelete(NULL);
+}
+
+void MicStream::captureLoop() {
+    int32_t block[MIC_DMA_LEN];
+    size_t bytes_read;
+
+    while (true) {
+        if (_paused) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        // Returns as soon as one DMA buffer completes
+        if (i2s_read(I2S_NUM_1, block, sizeof(block), &bytes_read, pdMS_TO_TICKS(100)) != ESP_OK) continue;
+        int64_t now = esp_timer_get_time();
+        size_t n = bytes_read / sizeof(int32_t);
+        if (n == 0 || _paused) continue;
+
+        uint32_t w = _written.load(std::memory_order_relaxed);
+        size_t first = MIC_RING_SAMPLES - (w & (MIC_RING_SAMPLES - 1));
+        if (first > n) first = n;
+        memcpy(&_ring[w & (MIC_RING_SAMPLES - 1)], block, first * sizeof(int32_t));
+        memcpy(&_ring[0], block + first, (n - first) * sizeof(int32_t));
+
+        _anchorSeq.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _anchorSample = w + n - 1;
+        _anchorUs = now;
+        _anchorSeq.fetch_add(1, std::memory_order_release);
+
+        _written.store(w + n, std::memory_order_release);
+
+        for (int i = 0; i < _listenerCount; i++) _listeners[i].cb(_listeners[i].ctx, block, n, w);
+    }
+}
+
+int64_t MicStream::sampleToMicros(uint32_t index) const {
+    uint32_t seq;
+    uint32_t sample;
+    int64_t us;
+    do {
+        seq = _anchorSeq.load(std::memory_order_acquire);
+        sample = _anchorSample;
+        us = _anchorUs;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != _anchorSeq.load(std::memory_order_acquire));
+    return us + (int64_t)(int32_t)(index - sample) * 1000000LL / MIC_SAMPLE_RATE;
+}
+
+bool MicStream::copy(uint32_t index, int32_t* dst, size_t n) const {
+    size_t first = MIC_RING_SAMPLES - (index & (MIC_RING_SAMPLES - 1));
+    if (first > n) first = n;
+    memcpy(dst, &_ring[index & (MIC_RING_SAMPLES - 1)], first * sizeof(int32_t));
+    memcpy(dst + first, &_ring[0], (n - first) * sizeof(int32_t));
+
+    // The block being written next may already cover the oldest slots
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return written() + MIC_DMA_LEN - index <= MIC_RING_SAMPLES;
+}
+
+// --- MicReader ---------------------------------------------------------------
+
+void MicReader::attach(MicStream* stream) {
+    _stream = stream;
+    _cursor = stream->written();
+    _overruns = 0;
+}
+
+// Cursor, moved past a pause gap and out of the region the writer may reuse
+uint32_t MicReader::start(uint32_t w) const {
+    uint32_t from = _cursor;
+    if ((int32_t)(from - _stream->resumeIndex()) < 0) from = _stream->resumeIndex();
+    if (w - from > MIC_RING_SAMPLES - MIC_DMA_LEN) from = w - MIC_RING_SAMPLES / 2;
+    return from;
+}
+
+size_t MicReader::available() const {
+    if (!_stream) return 0;
+    uint32_t w = _stream->written();
+    return w - start(w);
+}
+
+size_t MicReader::read(int32_t* dst, size_t maxSamples) {
+    if (!_stream) return 0;
+    uint32_t w = _stream->written();
+    uint32_t from = start(w);
+    // Moving ahead is only an overrun if it wasn't just a pause gap
+    if (from != _cursor && (int32_t)(_cursor - _stream->resumeIndex()) >= 0) _overruns++;
+
+    size_t n = w - from;
+    if (n > maxSamples) n = maxSamples;
+    if (!_stream->copy(from, dst, n)) {
+        _overruns++;
+        _cursor = w;
+        return 0;
+    }
+    _cursor = from + n;
+    return n;
+}
+
+void MicReader::skipToLatest() {
+    if (_stream) _cursor = _stream->written();
+}
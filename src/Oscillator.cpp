@@ -0,0 +1,61 @@
+#include "Oscillator.h"
+#include "AudioEngine.h"
+
+int16_t Oscillator::_table[OSC_TABLE_SIZE + 1];
+bool Oscillator::_tableReady = false;
+
+void Oscillator::initTable() {
+    if (_tableReady) return;
+    for (int i = 0; i <= OSC_TABLE_SIZE; i++) {
+        _table[i] = (int16_t)lrint(32767.0 * sin(2.0 * PI * i / OSC_TABLE_SIZE));
+    }
+    _tableReady = true;
+}
+
+void Oscillator::setFrequency(float hz, uint32_t sampleRate) {
+    // Phase increment = hz / sampleRate in units of 2^-32 turns
+    _inc = (uint32_t)((double)hz / (double)sampleRate * 4294967296.0);
+}
+
+#ifdef AUDIO_BENCHMARK
+void benchmarkOscillator() {
+    const int chunks = 64;
+    volatile float sink = 0.0f; // Keeps the loops from being optimized out
+    Oscillator::initTable();
+
+    // Legacy path: double-precision sin() for click + tone per sample
+    float clickPhase = 0.0f, tonePhase = 0.0f;
+    const float clickInc = (2.0f * PI * 2500.0f) / SAMPLE_RATE;
+    const float toneInc = (2.0f * PI * 440.0f) / SAMPLE_RATE;
+    uint32_t start = ESP.getCycleCount();
+    for (int c = 0; c < chunks; c++) {
+        float acc = 0.0f;
+        for (int i = 0; i < AUDIO_CHUNK_SAMPLES; i++) {
+            acc += sin(clickPhase) + sin(tonePhase) * 0.7f;
+            clickPhase += clickInc;
+            if (clickPhase > 2.0f * PI) clickPhase -= 2.0f * PI;
+            tonePhase += toneInc;
+            if (tonePhase > 2.0f * PI) tonePhase -= 2.0f * PI;
+        }
+        sink = sink + acc;
+    }
+    uint32_t libmCycles = (ESP.getCycleCount() - start) / chunks;
+
+    // Wavetable path: same two voices
+    Oscillator click, tone;
+    click.setFrequency(2500.0f, SAMPLE_RATE);
+    tone.setFrequency(440.0f, SAMPLE_RATE);
+    start = ESP.getCycleCount();
+    for (int c = 0; c < chunks; c++) {
+        int32_t acc = 0;
+        for (int i = 0; i < AUDIO_CHUNK_SAMPLES; i++) {
+            acc += click.nextQ15() + ((tone.nextQ15() * 22938) >> 15); // 0.7 in Q15
+        }
+        sink = sink + (float)acc;
+    }
+    uint32_t tableCycles = (ESP.getCycleCount() - start) / chunks;
+
+    Serial.printf("Oscillator bench (%d samples): sin() %u cycles, table %u cycles\n",
+                  AUDIO_CHUNK_SAMPLES, libmCycles, tableCycles);
+}
+#endif
@@ -0,0 +1,72 @@
+#include "RealFFT.h"
+
+#ifdef AUDIO_BENCHMARK
+// Reference: what the tuner did with arduinoFFT (double complex FFT on
+// real input, Hamming window evaluated per call, magnitude per bin)
+static void referenceFFT(double* re, double* im, int n) {
+    for (int i = 0; i < n; i++) re[i] *= 0.54 - 0.46 * cos(2.0 * PI * i / (n - 1));
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    for (int size = 2; size <= n; size <<= 1) {
+        double ang = -2.0 * PI / size;
+        for (int s = 0; s < n; s += size) {
+            for (int k = 0; k < size / 2; k++) {
+                double wr = cos(ang * k), wi = sin(ang * k);
+                double* ar = re + s + k;
+                double* ai = im + s + k;
+                double br = ar[size / 2] * wr - ai[size / 2] * wi;
+                double bi = ar[size / 2] * wi + ai[size / 2] * wr;
+                ar[size / 2] = *ar - br;
+                ai[size / 2] = *ai - bi;
+                *ar += br;
+                *ai += bi;
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) re[i] = sqrt(re[i] * re[i] + im[i] * im[i]);
+}
+
+void benchmarkFFT() {
+    const int n = 1024;
+    const int frames = 4;
+    volatile float sink = 0.0f;
+
+    double* re = (double*)malloc(n * sizeof(double));
+    double* im = (double*)malloc(n * sizeof(double));
+    uint32_t start = ESP.getCycleCount();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < n; i++) { re[i] = sin(2.0 * PI * 110.0 * i / 16000.0); im[i] = 0.0; }
+        referenceFFT(re, im, n);
+        sink = sink + (float)re[7];
+    }
+    uint32_t doubleCycles = (ESP.getCycleCount() - start) / frames;
+    free(re);
+    free(im);
+
+    RealFFT<n>* fft = new RealFFT<n>();
+    fft->begin();
+    float* buf = (float*)malloc(n * sizeof(float));
+    start = ESP.getCycleCount();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < n; i++) buf[i] = sinf(2.0f * PI * 110.0f * i / 16000.0f);
+        fft->applyWindow(buf);
+        fft->forward(buf);
+        RealFFT<n>::power(buf);
+        sink = sink + buf[7];
+    }
+    uint32_t floatCycles = (ESP.getCycleCount() - start) / frames;
+
+    Serial.printf("FFT %d (incl. input fill): double complex %u cycles, %u bytes | float real %u cycles, %u bytes\n",
+                  n, doubleCycles, (unsigned)(2 * n * sizeof(double)),
+                  floatCycles, (unsigned)(sizeof(RealFFT<n>) + n * sizeof(float)));
+    free(buf);
+    delete fft;
+}
+#endif
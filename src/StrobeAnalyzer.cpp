@@ -0,0 +1,110 @@
+#include "StrobeAnalyzer.h"
+
+static float wrapPi(float a) {
+    while (a > PI) a -= 2.0f * PI;
+    while (a < -PI) a += 2.0f * PI;
+    return a;
+}
+
+void StrobeAnalyzer::begin() {
+    _windowLen = 0;
+    for (int h = 0; h < STROBE_HARMONICS; h++) _omega[h] = 0;
+    reset();
+}
+
+void StrobeAnalyzer::setTarget(float hz, float sampleRate) {
+    _targetHz = hz;
+    for (int h = 0; h < STROBE_HARMONICS; h++) {
+        float f = hz * (h + 1);
+        // The fundamental is always tracked; overtones only while in band
+        _omega[h] = (h == 0 || f < STROBE_MAX_HZ) ? 2.0f * PI * f / sampleRate : 0.0f;
+        _cosW[h] = cosf(_omega[h]);
+        _sinW[h] = sinf(_omega[h]);
+    }
+    reset();
+}
+
+void StrobeAnalyzer::reset() {
+    _havePrev = false;
+    _head = 0;
+    _count = 0;
+    _phase = 0;
+    _cents = 0;
+}
+
+void StrobeAnalyzer::process(const float* frame, int n, uint32_t start) {
+    if (_targetHz <= 0.0f || n > PITCH_MAX_FRAME) return;
+    if (n != _windowLen) {
+        for (int i = 0; i < n; i++) _window[i] = 0.5f - 0.5f * cosf(2.0f * PI * i / (n - 1));
+        _windowLen = n;
+        _havePrev = false;
+    }
+
+    // Goertzel recurrences for all harmonics in one pass over the frame
+    float s1[STROBE_HARMONICS] = {}, s2[STROBE_HARMONICS] = {};
+    float coeff[STROBE_HARMONICS];
+    for (int h = 0; h < STROBE_HARMONICS; h++) coeff[h] = 2.0f * _cosW[h];
+    for (int i = 0; i < n; i++) {
+        float x = frame[i] * _window[i];
+        for (int h = 0; h < STROBE_HARMONICS; h++) {
+            float s = x + coeff[h] * s1[h] - s2[h];
+            s2[h] = s1[h];
+            s1[h] = s;
+        }
+    }
+
+    // Phase of each harmonic relative to the frame start (up to a constant
+    // that is the same for every frame, so it cancels in the differences)
+    uint32_t hop = start - _lastStart;
+    bool continuous = _havePrev && hop > 0 && hop <= STROBE_MAX_GAP;
+    if (!continuous) _count = 0; // The drift over the gap is unknown
+    float num = 0, den = 0;
+    // A harmonic whose phase can wrap within the hop at the largest
+    // deviation would alias; the fundamental always stays
+    const float range = powf(2.0f, STROBE_RANGE_CENTS / 1200.0f) - 1.0f;
+    for (int h = 0; h < STROBE_HARMONICS; h++) {
+        if (_omega[h] == 0.0f) continue;
+        if (h > 0 && _omega[h] * hop * range >= PI) continue;
+        float re = s1[h] - _cosW[h] * s2[h];
+        float im = _sinW[h] * s2[h];
+        float phase = atan2f(im, re);
+        if (continuous) {
+            // Drift beyond what the target frequency explains, in fundamental
+            // radians; harmonic h resolves it h times finer, so it is
+            // weighted by power * h^2
+            float r = wrapPi(phase - _lastPhase[h] - _omega[h] * hop) / (h + 1);
+            float w = (re * re + im * im) * (h + 1) * (h + 1);
+            num += r * w;
+            den += w;
+        }
+        _lastPhase[h] = phase;
+    }
+    _lastStart = start;
+    _havePrev = true;
+    if (!continuous || den <= 0.0f) return;
+
+    // A sharp note makes the drift grow
+    float drift = (_count ? _drift[(_head + STROBE_HISTORY - 1) % STROBE_HISTORY] : 0.0f) + num / den;
+    _drift[_head] = drift;
+    _time[_head] = start;
+    _head = (_head + 1) % STROBE_HISTORY;
+    if (_count < STROBE_HISTORY) _count++;
+    float turns = drift / (2.0f * PI);
+    _phase = turns - floorf(turns);
+
+    // Least-squares slope of drift over time: rad/sample of frequency error
+    if (_count < 2) return;
+    int oldest = (_head + STROBE_HISTORY - _count) % STROBE_HISTORY;
+    uint32_t t0 = _time[oldest];
+    float st = 0, sd = 0, stt = 0, std = 0;
+    for (int i = 0; i < _count; i++) {
+        int k = (oldest + i) % STROBE_HISTORY;
+        float t = (float)(_time[k] - t0);
+        float d = _drift[k];
+        st += t; sd += d; stt += t * t; std += t * d;
+    }
+    float var = _count * stt - st * st;
+    if (var <= 0.0f) return;
+    float slope = (_count * std - st * sd) / var;
+    _cents = 1200.0f * log2f(1.0f + slope / _omega[0]);
+}
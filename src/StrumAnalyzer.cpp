@@ -0,0 +1,168 @@
+#include "StrumAnalyzer.h"
+#include <new>
+#include <esp_heap_caps.h>
+
+struct StrumTuning {
+    const char* name;
+    uint8_t count;
+    uint8_t notes[STRUM_MAX_STRINGS]; // MIDI, lowest string first
+};
+
+static const StrumTuning kTunings[STRUM_INSTRUMENT_COUNT] = {
+    {"GTR",   6, {40, 45, 50, 55, 59, 64}},
+    {"BASS4", 4, {28, 33, 38, 43}},
+    {"BASS5", 5, {23, 28, 33, 38, 43}},
+};
+
+const char* StrumAnalyzer::instrumentName(StrumInstrument instrument) {
+    return kTunings[instrument].name;
+}
+
+bool StrumAnalyzer::begin() {
+    if (_fft) return true;
+    _history = (float*)heap_caps_malloc(2 * STRUM_SAMPLES * sizeof(float), MALLOC_CAP_8BIT);
+    _fft = _history ? new (std::nothrow) RealFFT<STRUM_SAMPLES>() : nullptr;
+    if (!_fft) {
+        end();
+        return false;
+    }
+    _frame = _history + STRUM_SAMPLES;
+    _fft->begin();
+    _histFill = 0;
+    setInstrument(_instrument);
+    return true;
+}
+
+void StrumAnalyzer::end() {
+    delete _fft;
+    _fft = nullptr;
+    if (_history) heap_caps_free(_history);
+    _history = nullptr;
+    _frame = nullptr;
+    _histFill = 0;
+}
+
+void StrumAnalyzer::setInstrument(StrumInstrument instrument) {
+    _instrument = instrument;
+    const StrumTuning& tuning = kTunings[instrument];
+    for (int s = 0; s < tuning.count; s++) {
+        _partials[s] = 1; // The fundamental always counts
+        for (int h = 2; h <= STRUM_HARMONICS; h++) {
+            bool shared = false;
+            for (int t = 0; t < tuning.count && !shared; t++) {
+                if (t == s) continue;
+                for (int g = 1; g <= STRUM_HARMONICS; g++) {
+                    // Interval between the two partials, independent of A4
+                    float cents = 1200.0f * log2f((float)h / g) + 100.0f * (tuning.notes[s] - tuning.notes[t]);
+                    if (fabsf(cents) < STRUM_COLLISION_CENTS) {
+                        shared = true;
+                        break;
+                    }
+                }
+            }
+            if (!shared) _partials[s] |= 1 << (h - 1);
+        }
+    }
+}
+
+// Magnitude at an arbitrary frequency: a parabola through the nearest bin
+// and its neighbours. (Linear interpolation would put every peak on a bin
+// centre, 80 cents wide at E2.)
+static float magnitudeAt(const float* mag, float hz, float binHz) {
+    float pos = hz / binHz;
+    int k = (int)(pos + 0.5f);
+    if (k < 1 || k >= STRUM_SAMPLES / 2 - 1) return 0.0f;
+    float x = pos - k;
+    float a = mag[k - 1], b = mag[k], c = mag[k + 1];
+    return b + 0.5f * x * (c - a) + 0.5f * x * x * (a - 2.0f * b + c);
+}
+
+// Partials weighted 1/h so the fundamental dominates and an overtone of a
+// lower string (E2's 3rd partial sits on B3) pulls less on its neighbour
+float StrumAnalyzer::harmonicSum(const float* mag, float hz, float binHz, uint8_t partials) const {
+    float sum = 0.0f;
+    for (int h = 1; h <= STRUM_HARMONICS && h * hz < STRUM_MAX_HZ; h++) {
+        if (partials & (1 << (h - 1))) sum += magnitudeAt(mag, h * hz, binHz) / h;
+    }
+    return sum;
+}
+
+void StrumAnalyzer::analyze(float sampleRate, float a4Ref, StrumResult& out) {
+    const StrumTuning& tuning = kTunings[_instrument];
+    out.count = tuning.count;
+    if (!_fft) return;
+
+    // Unroll the window, then take its magnitude spectrum in place
+    float* frame = _frame;
+    uint32_t from = _histHead - STRUM_SAMPLES;
+    for (int i = 0; i < STRUM_SAMPLES; i++) frame[i] = _history[(from + i) & (STRUM_SAMPLES - 1)];
+    _fft->applyWindow(frame);
+    _fft->forward(frame);
+    RealFFT<STRUM_SAMPLES>::power(frame);
+    const int bins = STRUM_SAMPLES / 2;
+    for (int k = 0; k < bins; k++) frame[k] = sqrtf(frame[k]);
+    const float binHz = sampleRate / STRUM_SAMPLES;
+
+    // Noise floor: median magnitude over the passband (nth_element-free:
+    // a 32-bucket log histogram is plenty for a threshold)
+    int hist[32] = {};
+    int used = 0;
+    for (int k = 1; k < bins && k * binHz < STRUM_MAX_HZ; k++) {
+        int b = frame[k] > 1.0f ? (int)(log2f(frame[k]) + 0.5f) : 0;
+        if (b > 31) b = 31;
+        hist[b]++;
+        used++;
+    }
+    int acc = 0, medianBucket = 0;
+    while (medianBucket < 31 && (acc += hist[medianBucket]) < used / 2) medianBucket++;
+    const float floor = (float)(1UL << medianBucket);
+
+    const int steps = 2 * STRUM_TOLERANCE_CENTS / STRUM_STEP_CENTS + 1;
+    float best[STRUM_MAX_STRINGS];
+    float strongest = 0.0f;
+    for (int s = 0; s < tuning.count; s++) {
+        StrumString& str = out.strings[s];
+        str.note = tuning.notes[s];
+        float target = a4Ref * powf(2.0f, (str.note - 69) / 12.0f);
+
+        // Scan the window on a cents grid and keep the best candidate with
+        // its neighbours for interpolation
+        float prev = 0.0f, peak = 0.0f, before = 0.0f, after = 0.0f;
+        int peakStep = -1;
+        for (int i = 0; i < steps; i++) {
+            float cents = -STRUM_TOLERANCE_CENTS + i * STRUM_STEP_CENTS;
+            float v = harmonicSum(frame, target * powf(2.0f, cents / 1200.0f), binHz, _partials[s]);
+            if (v > peak) {
+                peak = v;
+                peakStep = i;
+                before = prev;
+                after = 0.0f;
+            } else if (i == peakStep + 1) {
+                after = v;
+            }
+            prev = v;
+        }
+
+        // Floor of a harmonic sum: the floor per partial times the weights
+        float weights = 0.0f;
+        for (int h = 1; h <= STRUM_HARMONICS && h * target < STRUM_MAX_HZ; h++) {
+            if (_partials[s] & (1 << (h - 1))) weights += 1.0f / h;
+        }
+        bool heard = peakStep > 0 && peakStep < steps - 1 && peak > STRUM_MIN_SNR * floor * weights;
+        best[s] = heard ? peak : 0.0f;
+        if (best[s] > strongest) strongest = best[s];
+
+        float delta = 0.0f;
+        float denom = before - 2.0f * peak + after;
+        if (denom < 0.0f) delta = 0.5f * (before - after) / denom;
+        float cents = -STRUM_TOLERANCE_CENTS + (peakStep + delta) * STRUM_STEP_CENTS;
+        str.centsX10 = heard ? (int16_t)lroundf(cents * 10.0f) : 0;
+    }
+
+    for (int s = 0; s < tuning.count; s++) {
+        StrumString& str = out.strings[s];
+        if (best[s] < STRUM_MIN_SHARE * strongest) best[s] = 0.0f;
+        str.level = best[s] > 0.0f ? (uint8_t)lroundf(255.0f * best[s] / strongest) : 0;
+        if (str.level == 0) str.centsX10 = 0;
+    }
+}
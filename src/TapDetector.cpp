@@ -0,0 +1,160 @@
+#include "TapDetector.h"
+
+static const uint32_t kRefractorySamples = (uint32_t)TAP_REFRACTORY_MS * MIC_SAMPLE_RATE / 1000;
+static const uint32_t kPeakWindowSamples = (uint32_t)TAP_PEAK_WINDOW_MS * MIC_SAMPLE_RATE / 1000;
+static const float kEnvRelease = 0.99377f;  // ~10 ms decay at 16 kHz
+static const float kFloorRate = 0.0005f;    // ~125 ms noise floor tracking
+static const float kCouplingUp = 0.125f;    // Per measured click: rise slowly,
+static const float kCouplingDown = 0.5f;    // fall fast (a tap can only inflate a reading)
+
+void TapDetector::begin(MicStream* mic) {
+    _mic = mic;
+    mic->addListener(&TapDetector::onBlockCb, this);
+}
+
+void TapDetector::flush() {
+    TapOnset onset;
+    while (_onsets.pop(onset)) {}
+}
+
+void TapDetector::onBlockCb(void* ctx, const int32_t* samples, size_t n, uint32_t firstIndex) {
+    static_cast<TapDetector*>(ctx)->process(samples, n, firstIndex);
+}
+
+// Expected level of our own clicks (output units) at the mic at time us: the
+// exact decay envelope of each click, held at its peak across the arrival slack.
+// onset is set to the click whose arrival window contains us, if any.
+float TapDetector::expectedClick(int64_t us, const ClickEmission*& onset) const {
+    const int64_t latency = _latencyUs;
+    float level = 0.0f;
+    onset = nullptr;
+    for (size_t c = 0; c < _clickCount; c++) {
+        const ClickEmission& click = _clicks[c];
+        int64_t dt = us - (click.heardUs + latency);
+        if (dt < -TAP_CLICK_SLACK_US) continue;
+        if (dt <= TAP_CLICK_SLACK_US) {
+            level += click.level;
+            if (!onset) onset = &click; // Newest first
+            continue;
+        }
+        int64_t tail = dt - TAP_CLICK_SLACK_US;
+        if (tail > click.lengthUs || click.decayUs == 0) continue;
+        level += click.level * expf(-(float)tail / (float)click.decayUs);
+    }
+    return level;
+}
+
+// Follows one click through the mic: the envelope peak around its arrival,
+// then the tail against the click's own decay from that peak. The lowest
+// envelope/curve ratio is the coupling; a tap on top of the click (too short
+// to follow the curve) only raises the ratio for a while, so the minimum
+// along the tail sees through it.
+void TapDetector::measureClick(int64_t us, const ClickEmission* onset) {
+    if (_measureUs) {
+        bool same = onset && onset->heardUs == _measureUs;
+        if (_measureRising && !same) {
+            _measureRising = false;
+            _measureMin = _measurePeak;
+        }
+        if (!_measureRising) {
+            float dt = (float)(us - _measurePeakUs);
+            if (onset || dt > _measureDecayUs * TAP_COUPLING_TAIL) {
+                learnCoupling();
+            } else {
+                float ratio = _env * expf(dt / _measureDecayUs);
+                if (ratio < _measureMin) _measureMin = ratio;
+            }
+        }
+    }
+    if (onset && !_measureUs && onset->decayUs > 0) {
+        _measureUs = onset->heardUs;
+        _measureLevel = onset->level;
+        _measureDecayUs = (float)onset->decayUs;
+        _measureRising = true;
+        _measurePeak = 0.0f;
+        _measurePeakUs = us;
+        _measureTapped = _inPeak;
+    }
+}
+
+void TapDetector::learnCoupling() {
+    if (!_measureTapped && _measureLevel > 0.0f) {
+        float coupling = _measureMin / _measureLevel;
+        if (_coupling <= 0.0f) {
+            _coupling = coupling;
+        } else {
+            // Bounded step, so one odd reading can't blow it up
+            if (coupling > _coupling * 2.0f) coupling = _coupling * 2.0f;
+            if (coupling < _coupling * 0.5f) coupling = _coupling * 0.5f;
+            _coupling += (coupling - _coupling) * (coupling > _coupling ? kCouplingUp : kCouplingDown);
+        }
+    }
+    _measureUs = 0;
+}
+
+void TapDetector::process(const int32_t* samples, size_t n, uint32_t firstIndex) {
+    // Lower sensitivity -> tap must stand further above the noise floor
+    const float ratio = 3.0f + (1.0f - _sensitivity) * 12.0f;
+    float threshold = _floor * ratio;
+    if (threshold < TAP_MIN_LEVEL) threshold = TAP_MIN_LEVEL;
+
+    // Clicks are known well before they reach the mic (output buffering), so
+    // one snapshot per block covers every sample in it
+    _clickCount = _audio ? _audio->getRecentClicks(_clicks, TAP_MAX_CLICKS) : 0;
+    const int64_t blockUs = (_clickCount || _measureUs) ? _mic->sampleToMicros(firstIndex) : 0;
+    float clickLevel = 0.0f;
+    float gate = threshold;
+
+    for (size_t i = 0; i < n; i++) {
+        // Peak follower: instant attack, exponential release
+        float a = fabsf((float)(samples[i] >> 14));
+        _env = (a > _env) ? a : _env * kEnvRelease;
+        if (_sinceOnset != 0xFFFFFFFF) _sinceOnset++;
+
+        if (i % TAP_CLICK_SCAN == 0 && (_clickCount || _measureUs)) {
+            const ClickEmission* onset;
+            const int64_t us = blockUs + (int64_t)i * 1000000 / MIC_SAMPLE_RATE;
+            clickLevel = expectedClick(us, onset);
+            measureClick(us, onset);
+            // Until the coupling is known, our clicks are blanked outright
+            gate = threshold;
+            if (clickLevel > 0.0f) {
+                float expected = _coupling * clickLevel * TAP_CLICK_MARGIN;
+                gate = (_coupling > 0.0f) ? fmaxf(threshold, expected) : INFINITY;
+            }
+        }
+        if (_measureRising && _env > _measurePeak) {
+            _measurePeak = _env;
+            _measurePeakUs = blockUs + (int64_t)i * 1000000 / MIC_SAMPLE_RATE;
+        }
+
+        if (_inPeak) {
+            if (_env > _peak) _peak = _env;
+            if (_sinceOnset < kPeakWindowSamples) continue;
+
+            // Window over: classify against earlier taps
+            _inPeak = false;
+            TapOnset onset;
+            onset.sample = _onsetIndex;
+            onset.us = _mic->sampleToMicros(_onsetIndex) - _latencyUs;
+            onset.peak = _peak;
+            onset.accent = (_peakAvg > 0.0f) && (_peak > _peakAvg * TAP_ACCENT_RATIO);
+            _peakAvg = (_peakAvg > 0.0f) ? _peakAvg + (_peak - _peakAvg) * 0.2f : _peak;
+            _onsets.push(onset); // Dropped if the UI isn't listening
+        } else if (_env > gate && _sinceOnset >= kRefractorySamples) {
+            if (_measureUs) _measureTapped = true;
+            _inPeak = true;
+            _peak = _env;
+            _onsetIndex = firstIndex + i;
+            _sinceOnset = 0;
+        } else if (_sinceOnset >= kRefractorySamples &&
+                   (clickLevel <= 0.0f || (_coupling > 0.0f && _coupling * clickLevel < _floor))) {
+            // Only learn the floor outside taps, their ring-out and our clicks
+            _floor += (_env - _floor) * kFloorRate;
+            threshold = _floor * ratio;
+            if (threshold < TAP_MIN_LEVEL) threshold = TAP_MIN_LEVEL;
+            if (clickLevel <= 0.0f) gate = threshold;
+        }
+    }
+    _level = _env / gate;
+}
@@ -0,0 +1,123 @@
+#include "TempoEstimator.h"
+
+void TempoEstimator::reset() {
+    _head = 0;
+    _count = 0;
+    _periodUs = 0.0f;
+    _haveLast = false;
+    _pendingKind = 0;
+    _pendingCount = 0;
+    _pendingSum = 0.0f;
+    _onTempoRun = 0;
+}
+
+// Window update: binary search the evicted value, shift, binary search the
+// insert position. The window is tiny, so the shifts are a few words.
+void TempoEstimator::push(float interval) {
+    if (_count == TEMPO_WINDOW) {
+        float old = _ring[_head];
+        int lo = 0, hi = _count - 1;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (_sorted[mid] < old) lo = mid + 1;
+            else hi = mid;
+        }
+        memmove(&_sorted[lo], &_sorted[lo + 1], (_count - 1 - lo) * sizeof(float));
+        _count--;
+    }
+    _ring[_head] = interval;
+    _head = (_head + 1) % TEMPO_WINDOW;
+
+    int lo = 0, hi = _count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (_sorted[mid] < interval) lo = mid + 1;
+        else hi = mid;
+    }
+    memmove(&_sorted[lo + 1], &_sorted[lo], (_count - lo) * sizeof(float));
+    _sorted[lo] = interval;
+    _count++;
+}
+
+void TempoEstimator::update() {
+    // Trimmed mean of the middle half (plain median for tiny windows)
+    int from = _count / 4;
+    int to = _count - _count / 4;
+    float sum = 0.0f;
+    for (int i = from; i < to; i++) sum += _sorted[i];
+    _periodUs = sum / (to - from);
+}
+
+bool TempoEstimator::addOnset(int64_t us) {
+    if (!_haveLast) {
+        _haveLast = true;
+        _lastUs = us;
+        return false;
+    }
+    float interval = (float)(us - _lastUs);
+    if (interval <= 0.0f) return false;
+
+    if (_count == 0) {
+        _lastUs = us;
+        push(interval);
+        update();
+        return true;
+    }
+
+    float r = interval / _periodUs;
+    int kind;
+    if (fabsf(r - 1.0f) <= TEMPO_TOLERANCE) kind = 0;
+    else if (fabsf(r - 0.5f) <= TEMPO_TOLERANCE * 0.5f) kind = 1;
+    else if (fabsf(r - 2.0f) <= TEMPO_TOLERANCE) kind = 2;
+    else kind = 3;
+
+    if (kind == 0) {
+        // At double tempo doubled taps alternate with on-tempo intervals, so
+        // a pending "half" run survives one on-tempo interval
+        if (_pendingKind != 1 || ++_onTempoRun >= 2) {
+            _pendingKind = 0;
+            _pendingCount = 0;
+        }
+        _lastUs = us;
+        push(interval);
+        update();
+        return true;
+    }
+
+    // Off-tempo: the same deviation repeated means the player changed tempo
+    _onTempoRun = 0;
+    if (kind == _pendingKind) {
+        _pendingCount++;
+        _pendingSum += interval;
+    } else {
+        _pendingKind = kind;
+        _pendingCount = 1;
+        _pendingSum = interval;
+    }
+    if (_pendingCount >= TEMPO_CHANGE_TAPS) {
+        // Restart at the new tempo from the consistent intervals
+        _head = 0;
+        _count = 0;
+        float avg = _pendingSum / _pendingCount;
+        for (int i = 0; i < _pendingCount && i < TEMPO_WINDOW; i++) push(avg);
+        _pendingKind = 0;
+        _pendingCount = 0;
+        _lastUs = us;
+        update();
+        return true;
+    }
+
+    if (kind == 1) {
+        // Doubled tap: keep the previous onset as the reference
+        return false;
+    }
+    _lastUs = us;
+    if (kind == 2) {
+        // Missed tap: the gap holds two periods
+        push(interval * 0.5f);
+        push(interval * 0.5f);
+        update();
+        return true;
+    }
+    return false; // Single outlier (stumble) is ignored
+}
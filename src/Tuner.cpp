@@ -8,118 +8,217 @@ Tuner::Tuner() {
     // FFT object init if needed
 }
 
-void Tuner::begin() {
+void Tuner::begin(MicStream* mic) {
     if (_initialized) return;
-
-    i2s_config_t i2s_config = {
-        .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX),
-        .sample_rate = MIC_SAMPLE_RATE,
-        .bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT, // INMP441 uses 32-bit slots (24-bit data)
-        .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT, // Or RIGHT depending on connection. ONLY_LEFT is standard for mono INMP441
-        .communication_format = I2S_COMM_FORMAT_STAND_I2S,
-        .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-        .dma_buf_count = 4,
-        .dma_buf_len = 256
-    };
-    
-    i2s_pin_config_t pin_config = {
-        .bck_io_num = I2S_MIC_SCK,
-        .ws_io_num = I2S_MIC_WS,
-        .data_out_num = -1,
-        .data_in_num = I2S_MIC_SD
-    };
-
-    // Use I2S_NUM_1 for Input (Output is on NUM_0)
-    i2s_driver_install(I2S_NUM_1, &i2s_config, 0, NULL);
-    i2s_set_pin(I2S_NUM_1, &pin_config);
-    i2s_zero_dma_buffer(I2S_NUM_1);
-    
+    _fftEngine.begin();
+    _yinEngine.begin();
+    _frontEnd.begin();
+    _strobe.begin();
+    _pitchReader.attach(mic);
+    _histCursor = _pitchReader.position();
     _initialized = true;
 }
 
-int32_t Tuner::getAmplitude() {
-    if (!_initialized) return 0;
-
-    size_t bytes_read;
-    // Read a smaller chunk for responsiveness
-    int samples_to_read = 256; 
-    int32_t buffer[samples_to_read];
+void Tuner::setEngine(PitchEngineId id) {
+    switch (id) {
+        case PITCH_ENGINE_YIN: _engine = &_yinEngine; break;
+        default: id = PITCH_ENGINE_FFT; _engine = &_fftEngine; break;
+    }
+    _engineId = id;
+}
 
-    i2s_read(I2S_NUM_1, (void*)buffer, samples_to_read * sizeof(int32_t), &bytes_read, 0); // Non-blocking/Immediate return if possible? using 0 wait
+void Tuner::setHop(int samples) {
+    if (samples < TUNER_MIN_HOP) samples = TUNER_MIN_HOP;
+    if (samples > PITCH_MAX_FRAME) samples = PITCH_MAX_FRAME;
+    _hop = samples;
+}
 
-    int32_t maxAmp = 0;
-    for (int i=0; i < samples_to_read; i++) {
-        int32_t val = abs(buffer[i] >> 8); // Remove some LSB noise / align 24bit
-        if (val > maxAmp) maxAmp = val;
+// Run whatever the capture task produced since the last call through the
+// front-end and append it to the sliding window
+void Tuner::fillWindow() {
+    const int block = 256;
+    int32_t buf[block];
+    int32_t dec[block / TUNER_DECIMATION + 1];
+    size_t n;
+    while ((n = _pitchReader.read(buf, block)) > 0) {
+        // A pause or overrun leaves a hole: the old window no longer joins up
+        uint32_t from = _pitchReader.position() - n;
+        if (from != _histCursor) {
+            _frontEnd.reset();
+            _histFill = 0;
+            _hopCount = 0;
+            _strobeHopCount = 0;
+            if (_strumOn) _strumAnalyzer.clear();
+            for (int i = 0; i < TUNER_MEDIAN_LEN; i++) _recent[i] = 0;
+            _smoothed = 0;
+            unlockStrobe();
+        }
+        _histCursor = from + n;
+
+        size_t m = _frontEnd.process(buf, n, dec);
+        for (size_t i = 0; i < m; i++) {
+            _history[_histHead++ & (PITCH_MAX_FRAME - 1)] = dec[i];
+            if (_histFill < PITCH_MAX_FRAME) _histFill++;
+            if (_strumOn) _strumAnalyzer.push(dec[i]);
+            // The strobe needs consecutive phases, so it runs on every hop
+            // here rather than whenever the UI happens to poll
+            if (++_strobeHopCount == STROBE_HOP_SAMPLES) {
+                _strobeHopCount = 0;
+                feedStrobe();
+            }
+        }
+        _hopCount += m;
     }
-    return maxAmp;
 }
 
-void Tuner::stop() {
-    if (_initialized) {
-        i2s_driver_uninstall(I2S_NUM_1);
-        _initialized = false;
+// Runs the strobe filters on the window ending at the newest sample
+void Tuner::feedStrobe() {
+    if (!_strobeOn || _strobeNote < 0 || _strumOn) return;
+    const int n = _engine->frameSize();
+    if ((int)_histFill < n || _frontEnd.getLevel() < NOISE_THRESHOLD) return;
+    uint32_t from = _histHead - n;
+    for (int i = 0; i < n; i++) {
+        _frame[i] = (float)_history[(from + i) & (PITCH_MAX_FRAME - 1)];
     }
+    _strobe.process(_frame, n, from);
 }
 
 float Tuner::getFrequency() {
     if (!_initialized) return 0;
-    
-    size_t bytes_read;
-    // Read raw samples
-    i2s_read(I2S_NUM_1, (void*)i2s_raw_buffer, FFT_SAMPLES * sizeof(int32_t), &bytes_read, portMAX_DELAY);
-    
-    // Convert to double for FFT & Apply Window
-    // Also basic noise gate + AGC
-    double sum = 0;
-    double rms = 0;
-    
-    for (int i = 0; i < FFT_SAMPLES; i++) {
-        // INMP441 is 24-bit left aligned in 32-bit container. 
-        // Raw value needs shifting or just treating as big int.
-        // Actually usually standard I2S reads correctly into int32.
-        
-        int32_t val = i2s_raw_buffer[i];
-        // Reduce amplitude?
-        val = val >> 14; // Scaling down
-
-        // AGC: track RMS and apply gain
-        rms += (double)val * (double)val;
-        double amplified = (double)val * (double)_agcGain;
-        // prevent runaway
-        if (amplified > 8388607.0) amplified = 8388607.0;
-        if (amplified < -8388608.0) amplified = -8388608.0;
-
-        vReal[i] = amplified;
-        vImag[i] = 0;
-        sum += abs(val);
+
+    PitchEngine* engine = _engine;
+    const int n = engine->frameSize();
+    fillWindow();
+    if (_strumOn) {
+        if (_hopCount < STRUM_HOP_SAMPLES || !_strumAnalyzer.isFull()) return _smoothed;
+    } else if (_hopCount < _hop || (int)_histFill < n) {
+        return _smoothed;
+    }
+    // Only the newest window is analysed, however many hops arrived
+    _hopCount = 0;
+
+    // Noise Gate (front-end level before AGC)
+    if (_frontEnd.getLevel() < NOISE_THRESHOLD) {
+        _lastFrequency = 0;
+        _strumValid = false;
+        unlockStrobe();
+        return track(0); // Too quiet
     }
 
-    rms = sqrt(rms / FFT_SAMPLES);
-    if (rms > 1.0) {
-        // adjust gain gently toward target
-        const float target = 8000.0f;
-        float desired = target / (float)rms;
-        // smooth the change to avoid pumping
-        _agcGain = _agcGain * 0.9f + desired * 0.1f;
-        if (_agcGain < 0.01f) _agcGain = 0.01f;
-        if (_agcGain > 64.0f) _agcGain = 64.0f;
+    if (_strumOn) {
+        _strumAnalyzer.analyze(TUNER_SAMPLE_RATE, _a4Ref, _strumResult);
+        _strumValid = true;
+        return _smoothed;
     }
-    
-    // Noise Gate
-    if ((sum / FFT_SAMPLES) < NOISE_THRESHOLD) {
-        return 0; // Too quiet
+
+    // Unroll the newest n samples into the frame
+    uint32_t from = _histHead - n;
+    for (int i = 0; i < n; i++) {
+        _frame[i] = (float)_history[(from + i) & (PITCH_MAX_FRAME - 1)];
+    }
+
+    bool locked = _strobeOn && _strobeNote >= 0;
+    if (locked) {
+        // fillWindow() already fed the strobe; the engine only confirms
+        // the note now and then
+        if (++_coarseSkip < STROBE_COARSE_HOPS) return getStrobeFrequency();
+        _coarseSkip = 0;
     }
     
-    // Perform FFT
-    // Note: arduinoFFT v1.x API
-    FFT = arduinoFFT(vReal, vImag, FFT_SAMPLES, MIC_SAMPLE_RATE);
-    FFT.Windowing(FFT_WIN_TYP_HAMMING, FFT_FORWARD);
-    FFT.Compute(FFT_FORWARD);
-    FFT.ComplexToMagnitude();
-    
-    double peak = FFT.MajorPeak(vReal, FFT_SAMPLES, MIC_SAMPLE_RATE);
-    return (float)peak;
+    _lastFrequency = engine->detect(_frame, TUNER_SAMPLE_RATE);
+    float hz = track(_lastFrequency);
+    if (_strobeOn) {
+        updateStrobeTarget(hz);
+        if (_strobeNote >= 0) return getStrobeFrequency();
+    }
+    return hz;
+}
+
+void Tuner::setStrobe(bool on) {
+    _strobeOn = on;
+    unlockStrobe();
+}
+
+void Tuner::unlockStrobe() {
+    _strobeNote = -1;
+    _relockCount = 0;
+    _coarseSkip = 0;
+    _strobe.reset();
+}
+
+// Lock onto the note nearest the coarse estimate; a different note has to
+// persist for a few estimates so a stray octave reading doesn't reset the
+// phase track
+void Tuner::updateStrobeTarget(float hz) {
+    if (hz < 20.0f) return;
+    int note = (int)lroundf(12.0f * log2f(hz / _a4Ref) + 69.0f);
+    if (note == _strobeNote) {
+        _relockCount = 0;
+        return;
+    }
+    if (_strobeNote >= 0 && ++_relockCount < STROBE_RELOCK) return;
+    _strobeNote = note;
+    _relockCount = 0;
+    _strobe.setTarget(noteFrequency(note), TUNER_SAMPLE_RATE);
+}
+
+float Tuner::getStrobeFrequency() const {
+    if (!_strobe.hasReading()) return _smoothed;
+    return _strobe.getTarget() * powf(2.0f, _strobe.getCents() / 1200.0f);
+}
+
+// The strum buffers only exist while the mode is on
+void Tuner::setStrum(int instrument) {
+    _strumOn = instrument >= 0 && instrument < STRUM_INSTRUMENT_COUNT && _strumAnalyzer.begin();
+    if (_strumOn) _strumAnalyzer.setInstrument((StrumInstrument)instrument);
+    else _strumAnalyzer.end();
+    _strumValid = false;
+    _hopCount = 0;
+}
+
+bool Tuner::getStrumResult(StrumResult& out) const {
+    if (!_strumOn || !_strumValid) return false;
+    out = _strumResult;
+    return true;
+}
+
+bool Tuner::getStrobe(StrobeReading& out) const {
+    if (!_strobeOn || _strobeNote < 0 || !_strobe.hasReading()) return false;
+    out.note = _strobeNote;
+    out.targetHz = _strobe.getTarget();
+    out.cents = _strobe.getCents();
+    out.phase = _strobe.getPhase();
+    return true;
+}
+
+// Median of the last few estimates rejects single octave slips and
+// dropouts; the exponential stage then steadies the needle. Both run in
+// the log domain so the smoothing is uniform in cents across the range.
+float Tuner::track(float hz) {
+    _recent[_recentHead] = hz;
+    _recentHead = (_recentHead + 1) % TUNER_MEDIAN_LEN;
+
+    float sorted[TUNER_MEDIAN_LEN];
+    for (int i = 0; i < TUNER_MEDIAN_LEN; i++) {
+        // Insertion sort, a handful of values
+        float v = _recent[i];
+        int j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    float median = sorted[TUNER_MEDIAN_LEN / 2];
+
+    if (median < 20.0f) {
+        _smoothed = 0;
+    } else if (_smoothed < 20.0f || fabsf(1200.0f * log2f(median / _smoothed)) > TUNER_SNAP_CENTS) {
+        _smoothed = median; // New note
+    } else {
+        _smoothed *= powf(median / _smoothed, TUNER_SMOOTHING);
+    }
+    return _smoothed;
 }
 
 String Tuner::getNote(float frequency, int &cents) {
@@ -146,22 +245,3 @@ String Tuner::getNote(float frequency, int &cents) {
     String res = String(noteNames[noteIndex]) + String(octave);
     return res;
 }
-
-float Tuner::readLevel() {
-    if (!_initialized) return 0;
-    size_t bytes_read;
-    const int block = 256;
-    int32_t buf[block];
-    if (i2s_read(I2S_NUM_1, (void*)buf, block * sizeof(int32_t), &bytes_read, 0) != ESP_OK) {
-        return 0;
-    }
-    int samples = bytes_read / sizeof(int32_t);
-    double rms = 0;
-    for (int i = 0; i < samples; i++) {
-        int32_t v = buf[i] >> 14;
-        double amplified = (double)v * (double)_agcGain;
-        rms += amplified * amplified;
-    }
-    if (samples == 0) return 0;
-    return sqrt(rms / samples);
-}
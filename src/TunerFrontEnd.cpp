@@ -0,0 +1,109 @@
+#include "TunerFrontEnd.h"
+
+void TunerFrontEnd::begin() {
+    // Windowed-sinc lowpass (Hamming), normalised to unity DC gain
+    float h[FRONTEND_FIR_TAPS];
+    float sum = 0;
+    const float fc = (float)FRONTEND_FIR_CUTOFF_HZ / MIC_SAMPLE_RATE;
+    const float mid = (FRONTEND_FIR_TAPS - 1) * 0.5f;
+    for (int i = 0; i < FRONTEND_FIR_TAPS; i++) {
+        float t = i - mid;
+        float sinc = 2.0f * fc * (t == 0.0f ? 1.0f : sinf(2.0f * PI * fc * t) / (2.0f * PI * fc * t));
+        float w = 0.54f - 0.46f * cosf(2.0f * PI * i / (FRONTEND_FIR_TAPS - 1));
+        h[i] = sinc * w;
+        sum += h[i];
+    }
+    for (int i = 0; i < FRONTEND_FIR_TAPS; i++) {
+        _firTaps[FRONTEND_FIR_TAPS - 1 - i] = (int16_t)lroundf(h[i] / sum * 32767.0f);
+    }
+
+    // Butterworth high-pass (RBJ cookbook, Q = 1/sqrt(2)) at the output rate
+    const float w0 = 2.0f * PI * FRONTEND_HPF_HZ / TUNER_SAMPLE_RATE;
+    const float alpha = sinf(w0) / (2.0f * 0.70710678f);
+    const float cw = cosf(w0);
+    const float a0 = 1.0f + alpha;
+    const float q28 = 268435456.0f;
+    _b0 = (int32_t)lroundf((1.0f + cw) * 0.5f / a0 * q28);
+    _b1 = (int32_t)lroundf(-(1.0f + cw) / a0 * q28);
+    _b2 = _b0;
+    _a1 = (int32_t)lroundf(-2.0f * cw / a0 * q28);
+    _a2 = (int32_t)lroundf((1.0f - alpha) / a0 * q28);
+
+    reset();
+}
+
+void TunerFrontEnd::reset() {
+    _dcPrev = 0;
+    _dcAcc = 0;
+    memset(_firLine, 0, sizeof(_firLine));
+    _firPos = 0;
+    _firPhase = 0;
+    _x1 = _x2 = _y1 = _y2 = 0;
+    _hpErr = 0;
+    _blockSq = 0;
+    _blockAbs = 0;
+    _blockCount = 0;
+}
+
+size_t TunerFrontEnd::process(const int32_t* raw, size_t n, int32_t* out) {
+    size_t produced = 0;
+    for (size_t i = 0; i < n; i++) {
+        // INMP441 is 24-bit left aligned in 32-bit container
+        int32_t x = raw[i] >> 14; // Scaling down
+
+        // DC blocker
+        _dcAcc += ((x - _dcPrev) << 8) - (_dcAcc >> 8);
+        _dcPrev = x;
+        int32_t y = _dcAcc >> 8;
+
+        _firLine[_firPos] = y;
+        _firLine[_firPos + FRONTEND_FIR_TAPS] = y;
+        if (++_firPos == FRONTEND_FIR_TAPS) _firPos = 0;
+        if (++_firPhase < TUNER_DECIMATION) continue;
+        _firPhase = 0;
+
+        // Decimated output: the FIR only runs for the samples that are kept,
+        // so each input costs FRONTEND_FIR_TAPS / TUNER_DECIMATION MACs
+        const int32_t* line = &_firLine[_firPos]; // Oldest first
+        int64_t acc = 0;
+        for (int k = 0; k < FRONTEND_FIR_TAPS; k++) acc += (int64_t)line[k] * _firTaps[k];
+        int32_t d = (int32_t)(acc >> 15);
+
+        // High-pass. With poles this close to z = 1 the recursion amplifies
+        // DC ~650x, so the truncated fraction is carried into the next
+        // sample instead of being dropped (first-order error feedback).
+        int64_t hp = (int64_t)_b0 * d + (int64_t)_b1 * _x1 + (int64_t)_b2 * _x2
+                   - (int64_t)_a1 * _y1 - (int64_t)_a2 * _y2 + _hpErr;
+        int32_t v = (int32_t)(hp >> 28);
+        _hpErr = (int32_t)(hp - ((int64_t)v << 28));
+        _x2 = _x1; _x1 = d;
+        _y2 = _y1; _y1 = v;
+
+        // AGC
+        int64_t g = ((int64_t)v * _gainQ16) >> 16;
+        // prevent runaway
+        if (g > FRONTEND_CLAMP) g = FRONTEND_CLAMP;
+        if (g < -FRONTEND_CLAMP) g = -FRONTEND_CLAMP;
+        out[produced++] = (int32_t)g;
+
+        _blockSq += (int64_t)v * v;
+        _blockAbs += v < 0 ? -v : v;
+        if (++_blockCount == FRONTEND_BLOCK) {
+            float rms = sqrtf((float)_blockSq / FRONTEND_BLOCK);
+            _level = (float)_blockAbs / FRONTEND_BLOCK;
+            _rms = rms * getGain();
+            if (rms > 1.0f) {
+                // adjust gain gently toward target to avoid pumping
+                float gain = getGain();
+                gain += (FRONTEND_AGC_TARGET / rms - gain) * FRONTEND_AGC_STEP;
+                if (gain < 0.01f) gain = 0.01f;
+                if (gain > 64.0f) gain = 64.0f;
+                _gainQ16 = (int32_t)(gain * 65536.0f);
+            }
+            _blockSq = 0;
+            _blockAbs = 0;
+            _blockCount = 0;
+        }
+    }
+    return produced;
+}
@@ -0,0 +1,142 @@
+#include "YinPitchEngine.h"
+
+// Integration window: the part of the frame every lag can be compared over
+static const int kWindow = YIN_WINDOW;
+
+// Lowest point of the parabola through three neighbouring lag values
+static float parabolaMin(float a, float b, float c) {
+    float denom = a - 2.0f * b + c;
+    return (denom > 0.0f) ? b - (a - c) * (a - c) / (8.0f * denom) : b;
+}
+
+static float parabolaOffset(float a, float b, float c) {
+    float denom = a - 2.0f * b + c;
+    return (denom > 0.0f) ? 0.5f * (a - c) / denom : 0.0f;
+}
+
+void YinPitchEngine::begin() {
+    // Fractional-delay taps (Hann-windowed sinc) for the positions between samples
+    for (int p = 0; p < YIN_UPSAMPLE; p++) {
+        float sum = 0;
+        for (int k = 0; k < YIN_INTERP_TAPS; k++) {
+            float t = (k - (YIN_INTERP_TAPS / 2 - 1)) - (float)p / YIN_UPSAMPLE;
+            float sinc = (t == 0.0f) ? 1.0f : sinf(PI * t) / (PI * t);
+            float w = 0.5f + 0.5f * cosf(PI * t / (YIN_INTERP_TAPS / 2));
+            _interp[p][k] = sinc * w;
+            sum += _interp[p][k];
+        }
+        for (int k = 0; k < YIN_INTERP_TAPS; k++) _interp[p][k] /= sum;
+    }
+}
+
+float YinPitchEngine::detect(float* x, float sampleRate) {
+    // Energy of the reference window and of the window shifted by tau
+    float e0 = 0.0f;
+    for (int j = 0; j < kWindow; j++) e0 += x[j] * x[j];
+    if (e0 <= 0.0f) return 0.0f;
+    float eTau = e0;
+
+    _cmnd[0] = 1.0f;
+    float runningSum = 0.0f;
+    int found = -1;
+    int bestTau = -1;
+    float bestVal = 1e9f;
+
+    for (int tau = 1; tau <= YIN_MAX_LAG; tau++) {
+        // Slide the shifted window's energy by one sample
+        eTau += x[tau + kWindow - 1] * x[tau + kWindow - 1] - x[tau - 1] * x[tau - 1];
+
+        float corr = 0.0f;
+        const float* y = x + tau;
+        for (int j = 0; j < kWindow; j++) corr += x[j] * y[j];
+        float d = e0 + eTau - 2.0f * corr;
+        if (d < 0.0f) d = 0.0f; // Rounding
+
+        runningSum += d;
+        float v = (runningSum > 0.0f) ? d * tau / runningSum : 1.0f;
+        _cmnd[tau] = v;
+
+        if (tau < YIN_MIN_LAG) continue;
+        if (v < bestVal) {
+            bestVal = v;
+            bestTau = tau;
+        }
+        if (found < 0) {
+            if (v < YIN_THRESHOLD) {
+                found = tau;
+            } else if (tau >= YIN_MIN_LAG + 2 && _cmnd[tau - 1] < _cmnd[tau - 2] && _cmnd[tau - 1] <= v &&
+                       parabolaMin(_cmnd[tau - 2], _cmnd[tau - 1], v) < YIN_THRESHOLD) {
+                // At a few samples per period the dip can fall between two
+                // lags, neither of which reaches the threshold on its own
+                found = tau - 1;
+                break;
+            }
+        } else if (v >= _cmnd[tau - 1]) {
+            // Passed the bottom of the first qualifying dip: done
+            found = tau - 1;
+            break;
+        } else {
+            found = tau;
+        }
+    }
+
+    int tau = found;
+    if (tau < 0) {
+        if (bestVal > YIN_UNVOICED) return 0.0f;
+        tau = bestTau;
+    }
+    if (tau <= YIN_MIN_LAG || tau >= YIN_MAX_LAG) return sampleRate / tau;
+
+    // Coarse position from the normalized curve (the lag after the dip is
+    // always filled: the scan either stopped there or ran to YIN_MAX_LAG)
+    float coarse = tau + parabolaOffset(_cmnd[tau - 1], _cmnd[tau], _cmnd[tau + 1]);
+    return sampleRate * YIN_UPSAMPLE / refine(x, coarse);
+}
+
+// Integer lags are too coarse at the decimated rate (a 440 Hz period is
+// only ~9 samples), so the dip is re-measured on a band-limited
+// YIN_UPSAMPLE x interpolation of the frame at five fine lags around the
+// coarse estimate. Returns the period in upsampled samples.
+// Frame value at index / YIN_UPSAMPLE samples
+float YinPitchEngine::fineSample(const float* x, int index) const {
+    const int half = YIN_INTERP_TAPS / 2;
+    const int n = index / YIN_UPSAMPLE;
+    const float* taps = _interp[index % YIN_UPSAMPLE];
+    float acc = 0.0f;
+    for (int k = 0; k < YIN_INTERP_TAPS; k++) {
+        int i = n + k - (half - 1);
+        if (i < 0) i = 0; // Hold the edge samples
+        if (i >= YIN_FRAME_SAMPLES) i = YIN_FRAME_SAMPLES - 1;
+        acc += x[i] * taps[k];
+    }
+    return acc;
+}
+
+// Only the integration window is kept upsampled; the lagged copies are
+// interpolated as they are compared, which halves the buffer
+float YinPitchEngine::refine(const float* x, float coarse) {
+    const int fineLen = YIN_FRAME_SAMPLES * YIN_UPSAMPLE;
+    const int window = kWindow * YIN_UPSAMPLE;
+    for (int j = 0; j < window; j++) _fine[j] = fineSample(x, j);
+
+    int center = (int)lroundf(coarse * YIN_UPSAMPLE);
+    if (center < 2) center = 2;
+    if (center + 2 + window > fineLen) center = fineLen - window - 2;
+
+    float d[5];
+    for (int i = 0; i < 5; i++) {
+        const int lag = center - 2 + i;
+        float acc = 0.0f;
+        for (int j = 0; j < window; j++) {
+            float diff = _fine[j] - fineSample(x, lag + j);
+            acc += diff * diff;
+        }
+        d[i] = acc;
+    }
+
+    int m = 1;
+    for (int i = 2; i < 4; i++) {
+        if (d[i] < d[m]) m = i;
+    }
+    return center - 2 + m + parabolaOffset(d[m - 1], d[m], d[m + 1]);
+}
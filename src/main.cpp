@@ -3,11 +3,17 @@
 #include <ESP32Encoder.h>
 #include <Wire.h>
 #include <Preferences.h>
-#include <driver/ledc.h>
-#include <Adafruit_NeoPixel.h>
+#include <esp_timer.h>
 #include "config.h"
 #include "AudioEngine.h"
+#include "LedRing.h"
+#include "FeedbackDriver.h"
+#include "MicStream.h"
 #include "Tuner.h"
+#include "TapDetector.h"
+#include "TempoEstimator.h"
+#include "MeterDetector.h"
+#include "LatencyCalibrator.h"
 
 // --- Global Objects ---------------------------------------------------------
 // Check config.h for pins. Using HW I2C for Speed.
@@ -15,9 +21,15 @@ U8G2_SH1107_128X128_F_HW_I2C u8g2(U8G2_R0, /* reset=*/ U8X8_PIN_NONE, /* clock=*
 
 ESP32Encoder encoder;
 AudioEngine audio;
+MicStream mic;
 Tuner tuner;
+TapDetector tapDetector;
+TempoEstimator tapTempo;
+MeterDetector tapMeter;
+LatencyCalibrator calibrator;
 Preferences prefs;
-Adafruit_NeoPixel pixels(WS2812_NUM_LEDS, WS2812_PIN, NEO_GRB + NEO_KHZ800);
+LedRing ledRing;
+FeedbackDriver feedback;
 
 // --- State Management -------------------------------------------------------
 enum AppState {
@@ -32,7 +44,8 @@ enum AppState {
     STATE_TIMER_MENU,  // Feature 3
     STATE_PRESETS_MENU, // New Submenu for Presets
     STATE_PRESET_SELECT, // Loading/Saving
-    STATE_QUICK_MENU    // New Overlay Menu
+    STATE_QUICK_MENU,   // New Overlay Menu
+    STATE_CALIBRATE     // Speaker -> mic latency measurement
 };
 
 AppState currentState = STATE_METRONOME;
@@ -76,26 +89,25 @@ const int NUM_TIME_SIGS = sizeof(timeSignatures) / sizeof(TimeSig);
 
 // --- Taptronic State --------------------------------------------------------
 struct TapEvent {
-    unsigned long time;
+    int64_t timeUs; // Onset time (esp_timer), sample-accurate from the detector
     float peakLevel;
     bool isAccent;
 };
-#define MAX_TAP_HISTORY 16
+#define MAX_TAP_HISTORY METER_MAX_TAPS
+// Ring buffer: keeps the latest MAX_TAP_HISTORY taps of a sequence
 TapEvent tapHistory[MAX_TAP_HISTORY];
-int tapHistoryHead = 0;
+int tapHistoryHead = 0;  // Next write slot
 int tapHistoryCount = 0;
+char tapGrouping[16] = ""; // Detected accent grouping, e.g. "2+2+3"
 
-// Peak detection state
-bool tapIsPeakFinding = false;
-float tapCurrentPeak = 0.0f;
-unsigned long tapPeakStartTime = 0;
-// Double Threshold Logic
-float tapBeatThreshold = 5000000.0f;   // Calculated from sensitivity
-float tapAccentThreshold = 8000000.0f; // Calculated from sensitivity * 1.5 approx
+// i = 0 is the oldest stored tap, tapHistoryCount - 1 the latest
+TapEvent& tapAt(int i) {
+    return tapHistory[(tapHistoryHead - tapHistoryCount + i + MAX_TAP_HISTORY) % MAX_TAP_HISTORY];
+}
 
 // --- Metronome Logic --------------------------------------------------------
 struct MetronomeState {
-    volatile int bpm = 120;
+    volatile float bpm = 120.0f; // Fractional tempos allowed (e.g. 97.5)
     volatile bool isPlaying = false;
     unsigned long lastBeatTime = 0;
     volatile int beatCounter = 0; // 0 = first beat (Accent)
@@ -127,8 +139,7 @@ bool trainerActive = false;
 int trainerStartBPM = 80;
 int trainerEndBPM = 120;
 int trainerStepBPM = 5;
-int trainerBarInterval = 4; // Increase every 4 bars
-int trainerBarCounter = 0;
+int trainerBarInterval = 4; // Increase every 4 bars (reached as a continuous ramp)
 // Trainer Menu UI
 int trainerMenuSelection = 0;
 bool trainerEditing = false; // Toggle between Nav (false) and Value Edit (true)
@@ -143,9 +154,10 @@ TaskHandle_t metronomeTaskHandle = NULL;
 
 // --- Menu Logic -------------------------------------------------------------
 // Updated Menu structure for Features
-const char* menuItems[] = {"Metric", "Subdiv", "Taptronic", "Trainer", "Timer", "Tuner", "Presets", "Vibration", "Exit"};
+const char* menuItems[] = {"Metric", "Subdiv", "Taptronic", "Trainer", "Timer", "Tuner", "Presets", "Vibration", "Audio", "Calibrate", "Exit"};
 int menuSelection = 0;
-int menuCount = 9;
+int menuCount = 11;
+#define MENU_VISIBLE_ROWS 7
 
 
 // Presets Menu
@@ -172,6 +184,8 @@ int tempSetlistID = 0;
 long lastEncoderValue = 0;
 unsigned long buttonPressTime = 0;
 bool buttonActive = false;
+bool buttonTurned = false; // Encoder moved while held: the release is not a click
+#define BPM_FINE_STEP 0.1f   // Per detent while the button is held
 bool buttonStableState = false;
 bool buttonLastRead = false;
 unsigned long buttonLastChange = 0;
@@ -179,8 +193,7 @@ unsigned long buttonLastChange = 0;
 // Tap Tempo Globals
 float tapSensitivity = 0.5f; // 0.0 to 1.0
 float tapInputLevel = 0.0f;
-unsigned long lastTapTime = 0;
-unsigned long tapIntervalAccumulator = 0;
+int64_t lastTapUs = 0;
 int tapCount = 0;
 bool showTapVisual = false;
 unsigned long tapVisualStartTime = 0;
@@ -188,16 +201,22 @@ unsigned long tapVisualStartTime = 0;
 
 // Haptics & Visuals
 bool hapticEnabled = true;
-unsigned long feedbackOffAt = 0;
 int hapticNormalDuty = 400; // 10-bit duty (0-1023)
 int hapticAccentDuty = 700;
 int feedbackPulseMs = 40;
 
 // Settings persistence
 float a4Reference = 440.0f;
-int tempBPM = 120; // For Adjust BPM Screen
+int32_t loopbackLatencyUs = TAP_ACOUSTIC_LATENCY_US; // DAC -> speaker -> mic, calibrated per unit
+float tempBPM = 120.0f; // For Adjust BPM Screen
 bool isTunerToneOn = false;
 
+// Tuner modes on the encoder: each pitch engine, strobe, then strum per instrument
+#define TUNER_MODE_STROBE PITCH_ENGINE_COUNT
+#define TUNER_MODE_STRUM (PITCH_ENGINE_COUNT + 1)
+#define TUNER_MODE_COUNT (TUNER_MODE_STRUM + STRUM_INSTRUMENT_COUNT)
+int tunerMode = PITCH_ENGINE_FFT;
+
 // --- Power Management -------------------------------------------------------
 unsigned long lastActivityTime = 0;
 
@@ -206,11 +225,18 @@ void drawMetronomeScreen();
 void drawMenuScreen();
 void drawPresetsMenuScreen(); // New
 void drawTunerScreen(float freq, String note, int cents);
+void drawStrobeScreen(const StrobeReading& r);
+void drawStrumScreen(const StrumResult& r);
+void setTunerMode(int mode);
 void drawTimeSigScreen();
 void drawBPMScreen(); 
 void drawTapScreen();
 void drawPresetScreen();
 void drawQuickMenuScreen();
+void drawCalibrateScreen();
+void setLoopbackLatency(int32_t us);
+void formatBPM(char* buf, size_t len, float bpm);
+float stepBPM(float bpm, long delta, bool fine);
 void enterDeepSleep();
 void saveSettings();
 void loadSettings();
@@ -218,79 +244,99 @@ void savePreset(int slot);
 void loadPreset(int slot);
 int getPresetSetlistID(int slot);
 
-// --- Audio Task (High Precision Metronome Trigger on Core 0) ----------------
+// --- Beat Feedback (Haptics + LED) ------------------------------------------
+// Pulses are queued for the moment the click is heard, not when it is rendered:
+// heardUs is when it reaches the DAC, the calibrated loopback covers amp and speaker
+void beatFeedback(bool accent, int64_t heardUs, int beat) {
+    FeedbackPulse pulse;
+    pulse.startUs = heardUs + loopbackLatencyUs;
+    pulse.durationUs = feedbackPulseMs * 1000;
+
+    // 1. Haptic (Only if enabled AND volume is 0)
+    pulse.duty = 0;
+    if (hapticEnabled && audio.getVolume() == 0) {
+        pulse.duty = accent ? hapticAccentDuty : hapticNormalDuty;
+    }
+
+    // 2. Visual (WS2812 ring): beat position, or a full flash for manual clicks
+    if (beat >= 0) pulse.ledFrame = ledRing.beatFrame(beat);
+    else pulse.ledFrame = accent ? LED_FRAME_FLASH_ACCENT : LED_FRAME_FLASH;
+
+    feedback.schedule(pulse);
+}
+
+// Manual clicks (tap feedback, alerts) have no bar position
+void clickFeedback(bool accent, int64_t heardUs) {
+    beatFeedback(accent, heardUs, -1);
+}
+
+// --- Metronome Task (Core 0) -------------------------------------------------
+// The beat clock itself lives in the audio task (sample-accurate). This task
+// only forwards UI parameters and reacts to the beats the audio task rendered.
 void metronomeTask(void * parameter) {
-    unsigned long lastBeat = millis();
-    unsigned long nextSubdivision = 0;
-    int subCounter = 0;
-    
+    float sentBPM = 0.0f;
+    bool rampArmed = false;
+    float rampRate = 0.0f;
+    int rampTarget = 0;
+
     for(;;) {
-        if (metronome.isPlaying && currentState == STATE_METRONOME) {
-            unsigned long interval = 60000 / metronome.bpm;
-            unsigned long now = millis();
-            
-            // Subdivisions Calc
-            int subs = metronome.subdivision + 1; // 1, 2, 3, 4 parts
-            unsigned long subInterval = interval / subs;
-
-            if (now - lastBeat >= interval) {
-                lastBeat = now;
-                nextSubdivision = now + subInterval;
-                subCounter = 1;
-                
-                // Play Click
-                bool isAccent = (metronome.beatCounter == 0);
-                audio.playClick(isAccent, false);
-                
-                // Advance Beat
-                metronome.beatCounter++;
-                if (metronome.beatCounter >= metronome.getBeatsPerBar()) {
-                    metronome.beatCounter = 0;
-                    
-                    // Feature 1: Trainer Auto-Increment
-                    if (trainerActive) {
-                        trainerBarCounter++;
-                        if (trainerBarCounter >= trainerBarInterval) {
-                            trainerBarCounter = 0;
-                            if (metronome.bpm < trainerEndBPM) {
-                                metronome.bpm += trainerStepBPM;
-                                if (metronome.bpm > trainerEndBPM) metronome.bpm = trainerEndBPM;
-                                encoder.setCount(metronome.bpm * 2); // Sync UI
-                            }
-                        }
-                    }
-                }
-            } else {
-                // Check Subdivisions
-                if (metronome.subdivision > 0 && subCounter < subs) {
-                    if (now >= nextSubdivision) {
-                         audio.playClick(false, true); // Play Sub
-                         nextSubdivision += subInterval;
-                         subCounter++;
-                    }
-                }
+        bool shouldRun = metronome.isPlaying && currentState == STATE_METRONOME;
+
+        // Only push tempo on UI changes so a running ramp is not reset
+        if (metronome.bpm != sentBPM) {
+            sentBPM = metronome.bpm;
+            audio.setTempo(sentBPM);
+        }
+        audio.setBeatsPerBar(metronome.getBeatsPerBar());
+        ledRing.setBeatsPerBar(metronome.getBeatsPerBar());
+        audio.setSubdivision(metronome.subdivision + 1); // 1, 2, 3, 4 parts
+
+        // Feature 1: Trainer as a continuous ramp
+        // Same average rate as "+Step BPM every N bars", spread over every beat.
+        if (trainerActive && !timerAlarmTriggered) {
+            float beatsPerStep = (float)(trainerBarInterval * metronome.getBeatsPerBar());
+            float rate = trainerStepBPM / beatsPerStep;
+            if (!rampArmed || rate != rampRate || trainerEndBPM != rampTarget) {
+                rampArmed = true;
+                rampRate = rate;
+                rampTarget = trainerEndBPM;
+                audio.setTempoRamp(rampTarget, rampRate);
             }
-            
-            // Feature 3: Timer Check
-            if (timerActive && !timerAlarmTriggered) {
-                if (now - timerStartTime > timerDuration) {
-                    timerAlarmTriggered = true;
-                    metronome.isPlaying = false; // Stop metronome
-                    // Maybe trigger a long haptic pulse or specific pattern?
-                    // For now, rely on UI showing "Time's Up!"
-                    hapticEnabled = true; 
-                    audio.playClick(true, false); // Single alert
-                }
+        } else if (rampArmed) {
+            rampArmed = false;
+            audio.clearTempoRamp();
+        }
+
+        if (shouldRun && !audio.isMetronomeRunning()) {
+            audio.startMetronome();
+        } else if (!shouldRun && audio.isMetronomeRunning()) {
+            audio.stopMetronome();
+            if (!metronome.isPlaying) metronome.beatCounter = 0;
+        }
+
+        BeatEvent evt;
+        if (audio.getBeatEvent(evt, pdMS_TO_TICKS(5))) {
+            metronome.beatCounter = evt.beat;
+            beatFeedback(evt.accent, evt.heardUs, evt.beat);
+
+            // Mirror ramp progress into the UI (display rounds to 0.1 BPM)
+            if (trainerActive) {
+                sentBPM = roundf(audio.getTempo() * 10.0f) / 10.0f;
+                metronome.bpm = sentBPM;
+            }
+        }
+
+        // Feature 3: Timer Check
+        if (shouldRun && timerActive && !timerAlarmTriggered) {
+            if (millis() - timerStartTime > timerDuration) {
+                timerAlarmTriggered = true;
+                metronome.isPlaying = false; // Stop metronome
+                // Maybe trigger a long haptic pulse or specific pattern?
+                // For now, rely on UI showing "Time's Up!"
+                hapticEnabled = true;
+                audio.playClick(true, false); // Single alert
             }
-            
-        } else {
-             if (!metronome.isPlaying) {
-                 metronome.beatCounter = 0;
-             }
-             lastBeat = millis(); // Reset reference
         }
-        
-        vTaskDelay(1 / portTICK_PERIOD_MS); // Yield
     }
 }
 
@@ -298,50 +344,39 @@ void metronomeTask(void * parameter) {
 void analyzeTapRhythm() {
     if (tapHistoryCount < 3) return;
 
-    // Reset accents based on current threshold (if dynamic) or just use stored flags
-    // finding the indices of accents
-    int accentIndices[MAX_TAP_HISTORY];
-    int accentCount = 0;
-    
-    // Scan history backwards to find most recent pattern
-    // History is a ring buffer? No, simple array for this session is easier 
-    // but the code uses a ring buffer approach "tapHistoryHead".
-    // Let's implement correct ring buffer iteration.
-    
-    // Actually, for simplicity, let's just iterate the valid count up to MAX
-    // If we treat it as a linear buffer that resets on silence, it's easier. 
-    // (See loop logic: tapHistoryCount resets on timeout).
-    // So we can just iterate 0 to tapHistoryCount-1.
-    
+    // Re-classify accents over the whole history and score bar lengths
+    float peaks[MAX_TAP_HISTORY];
+    bool accents[MAX_TAP_HISTORY];
     for (int i = 0; i < tapHistoryCount; i++) {
-        if (tapHistory[i].isAccent) {
-            accentIndices[accentCount++] = i;
-        }
+        peaks[i] = tapAt(i).peakLevel;
+        accents[i] = tapAt(i).isAccent; // Kept if there is too little to cluster
     }
-    
-    if (accentCount < 2) return;
-    
-    // Calculate interval between last two accents
-    int lastIdx = accentIndices[accentCount - 1];
-    int prevIdx = accentIndices[accentCount - 2];
-    int interval = lastIdx - prevIdx; // e.g. Acc at 0, Acc at 4 -> Interval 4 (4/4)
-    
-    if (interval > 0 && interval <= 12) {
-        // Try to match specific time signatures preferred by user
-        // Priority: /4 over /8?
-        int bestMatch = -1;
-        
-        // Search in timeSignatures
-        for (int i = 0; i < NUM_TIME_SIGS; i++) {
-            if (timeSignatures[i].num == interval) {
-                bestMatch = i;
-                // If we find a x/4, prefer it?
-                if (timeSignatures[i].den == 4) break; 
-            }
+
+    MeterResult meter;
+    // tapCount numbers the taps since the sequence started; the window
+    // holds the newest tapHistoryCount of them
+    bool changed = tapMeter.analyze(peaks, tapHistoryCount, (uint32_t)(tapCount - tapHistoryCount), accents, meter);
+    for (int i = 0; i < tapHistoryCount; i++) tapAt(i).isAccent = accents[i];
+    if (!changed) return;
+
+    // Grouped accents (2+2+3) read as /8, downbeat-only as /4
+    int preferDen = (meter.groupCount > 1) ? 8 : 4;
+    int bestMatch = -1;
+    for (int i = 0; i < NUM_TIME_SIGS; i++) {
+        if (timeSignatures[i].num == meter.beats) {
+            bestMatch = i;
+            if (timeSignatures[i].den == preferDen) break;
         }
-        
-        if (bestMatch != -1) {
-            metronome.timeSigIdx = bestMatch;
+    }
+    if (bestMatch != -1) {
+        metronome.timeSigIdx = bestMatch;
+    }
+
+    tapGrouping[0] = '\0';
+    if (meter.groupCount > 1) {
+        size_t len = 0;
+        for (int g = 0; g < meter.groupCount && len < sizeof(tapGrouping) - 3; g++) {
+            len += snprintf(tapGrouping + len, sizeof(tapGrouping) - len, g ? "+%d" : "%d", meter.groups[g]);
         }
     }
 }
@@ -354,13 +389,14 @@ void setup() {
     // Hardware Init
     audio.begin();
     u8g2.begin();
-    tuner.begin();
+    mic.begin(); // Capture stays paused until a mic mode is entered
+    tuner.begin(&mic);
+    tapDetector.begin(&mic);
+    tapDetector.setClickSource(&audio); // Our own clicks never count as taps
+    calibrator.begin(&audio, &mic);
     
-    // Pixels
-    pixels.begin();
-    pixels.setBrightness(200);
-    pixels.clear();
-    pixels.show();
+    // LED Ring (RMT)
+    ledRing.begin();
 
     // Preferences Init
     prefs.begin("taktobeat", false);
@@ -368,54 +404,19 @@ void setup() {
     
     ESP32Encoder::useInternalWeakPullResistors = UP;
     encoder.attachHalfQuad(ENC_PIN_A, ENC_PIN_B);
-    encoder.setCount(metronome.bpm * 2);
+    encoder.setCount((long)metronome.bpm * 2);
     lastEncoderValue = encoder.getCount() / 2;
     pinMode(ENC_BUTTON, INPUT_PULLUP);
     
-    // Haptic PWM init (LEDC Legacy API for Core 2.0.x)
-    ledc_timer_config_t ledc_timer = {
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .duty_resolution = LEDC_TIMER_10_BIT,
-        .timer_num = LEDC_TIMER_0,
-        .freq_hz = HAPTIC_PWM_FREQ,
-        .clk_cfg = LEDC_AUTO_CLK
-    };
-    ledc_timer_config(&ledc_timer);
-
-    ledc_channel_config_t ledc_channel = {
-        .gpio_num = HAPTIC_PIN,
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .channel = (ledc_channel_t)HAPTIC_PWM_CH,
-        .intr_type = LEDC_INTR_DISABLE,
-        .timer_sel = LEDC_TIMER_0,
-        .duty = 0,
-        .hpoint = 0
-    };
-    ledc_channel_config(&ledc_channel);
-
-    // Callback handles Haptic + Visuals
-    audio.setBeatCallback([](bool accent){
-        // 1. Haptic (Only if enabled AND volume is 0)
-        if (hapticEnabled && audio.getVolume() == 0) {
-            int duty = accent ? hapticAccentDuty : hapticNormalDuty;
-            ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)HAPTIC_PWM_CH, duty);
-            ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)HAPTIC_PWM_CH);
-        }
-        
-        // 2. Visual (WS2812)
-        if (accent) {
-            pixels.setPixelColor(0, pixels.Color(255, 0, 0)); // Red
-        } else {
-            pixels.setPixelColor(0, pixels.Color(0, 0, 255)); // Blue
-        }
-        pixels.show();
+    // Haptic PWM + pulse timing
+    feedback.begin(&ledRing);
 
-        feedbackOffAt = millis() + feedbackPulseMs;
-    });
+    // Callback handles Haptic + Visuals for manual clicks (tap feedback, alerts)
+    audio.setBeatCallback(clickFeedback);
 
     lastActivityTime = millis();
     
-    // Create Audio Task on Core 0
+    // Create Metronome Task on Core 0
     xTaskCreatePinnedToCore(
       metronomeTask,   "MetronomeTask", 
       4096,        NULL, 
@@ -424,6 +425,12 @@ void setup() {
     );
 
     Serial.println("Takt-O-Beat v" APP_VERSION " Ready.");
+
+#ifdef AUDIO_BENCHMARK
+    benchmarkOscillator();
+    benchmarkFFT();
+    Serial.printf("Tuner: %u bytes\n", (unsigned)sizeof(Tuner));
+#endif
 }
 
 // --- Main Loop --------------------------------------------------------------
@@ -448,13 +455,16 @@ void loop() {
             buttonStableState = rawBtn;
             if (buttonStableState) { // Press
                 buttonActive = true;
+                buttonTurned = false;
                 buttonPressTime = now;
                 lastActivityTime = now;
             } else { // Release
                 buttonActive = false;
                 long duration = now - buttonPressTime;
                 
-                if (duration < 500) { // Short Click
+                if (buttonTurned) {
+                    // Press-and-turn was a fine BPM adjustment, not a click
+                } else if (duration < 500) { // Short Click
                     // Single Press Handling
                     
                     // Priority Check: Setlist Editing
@@ -499,8 +509,9 @@ void loop() {
                              currentState = STATE_AM_SUBDIV;
                         } else if (menuSelection == 2) { // Tap Tempo
                              currentState = STATE_TAP_TEMPO;
-                             tuner.begin(); // Enable mic
-                             lastTapTime = 0;
+                             mic.resume(); // Enable mic
+                             tapDetector.flush();
+                             lastTapUs = 0;
                              tapCount = 0;
                         } else if (menuSelection == 3) { // Trainer (Simple Toggle/Conf for now)
                              // For simplicity: Quick set or navigate to trainer menu
@@ -514,14 +525,21 @@ void loop() {
                              timerAlarmTriggered = false;
                         } else if (menuSelection == 5) { // Tuner
                              currentState = STATE_TUNER;
-                             tuner.begin(); 
+                             mic.resume();
                         } else if (menuSelection == 6) { // Presets Menu
                              currentState = STATE_PRESETS_MENU;
                              presetsMenuSelection = 0;
                         } else if (menuSelection == 7) { // Vibration
                              hapticEnabled = !hapticEnabled;
                              saveSettings();
-                        } else if (menuSelection == 8) { // Exit
+                        } else if (menuSelection == 8) { // Audio profile (latency vs. battery)
+                             audio.setProfile((AudioProfileId)((audio.getProfile() + 1) % AUDIO_PROFILE_COUNT));
+                             saveSettings();
+                        } else if (menuSelection == 9) { // Latency calibration
+                             currentState = STATE_CALIBRATE;
+                             mic.resume();
+                             calibrator.start();
+                        } else if (menuSelection == 10) { // Exit
                              currentState = STATE_METRONOME;
                         }
                     } else if (currentState == STATE_PRESETS_MENU) {
@@ -539,8 +557,8 @@ void loop() {
                     } else if (currentState == STATE_TRAINER_MENU) {
                          if (trainerMenuSelection == 4) { // Start/Stop
                              trainerActive = !trainerActive;
-                             // Reset counter if starting
-                             if (trainerActive) trainerBarCounter = 0;
+                             // Ramp starts from the configured Start BPM
+                             if (trainerActive) metronome.bpm = trainerStartBPM;
                          } else {
                              // Toggle Edit Checkbox style
                              trainerEditing = !trainerEditing;
@@ -553,10 +571,10 @@ void loop() {
                         isTunerToneOn = !isTunerToneOn;
                         if (isTunerToneOn) {
                             audio.startTone(a4Reference);
-                            tuner.stop();
+                            mic.pause();
                         } else {
                             audio.stopTone();
-                            tuner.begin();
+                            mic.resume();
                         }
                     } else if (currentState == STATE_AM_TIME_SIG) {
                         currentState = STATE_MENU;
@@ -564,12 +582,16 @@ void loop() {
                     } else if (currentState == STATE_AM_BPM) {
                         currentState = STATE_MENU;
                         metronome.bpm = tempBPM;
-                        encoder.setCount(metronome.bpm * 2);
+                        encoder.setCount((long)metronome.bpm * 2);
                         saveSettings();
                     } else if (currentState == STATE_TAP_TEMPO) {
                         currentState = STATE_MENU;
-                        tuner.stop();
+                        mic.pause();
                         saveSettings();
+                    } else if (currentState == STATE_CALIBRATE) {
+                        calibrator.cancel(); // Keeps the previous value if still running
+                        currentState = STATE_MENU;
+                        mic.pause();
                     } else if (currentState == STATE_PRESET_SELECT) {
                         if (presetMode == PRESET_LOAD) loadPreset(presetSlot);
                         else {
@@ -605,10 +627,11 @@ void loop() {
                         encoder.setCount(tempSetlistID * 2); 
                     } else {
                         // Exit back to Metronome
+                        if (currentState == STATE_TUNER || currentState == STATE_TAP_TEMPO || currentState == STATE_CALIBRATE) mic.pause();
+                        calibrator.cancel();
                         currentState = STATE_METRONOME;
                         isTunerToneOn = false;
                         audio.stopTone();
-                        if (currentState == STATE_TUNER || currentState == STATE_TAP_TEMPO) tuner.stop();
                     }
                 }
             }
@@ -637,10 +660,8 @@ void loop() {
                 }
                 saveSettings();
             } else {
-                // Adjust BPM
-                metronome.bpm += delta;
-                if (metronome.bpm < 30) metronome.bpm = 30;
-                if (metronome.bpm > 300) metronome.bpm = 300;
+                // Adjust BPM (whole steps keep any fractional part)
+                metronome.bpm = stepBPM(metronome.bpm, delta, false);
             }
         } else if (currentState == STATE_MENU) {
             menuSelection += delta;
@@ -691,9 +712,9 @@ void loop() {
              if (mins > 60) mins = 60;
              timerDuration = mins * 60000;
         } else if (currentState == STATE_AM_BPM) {
-            tempBPM += delta;
-            if (tempBPM < 30) tempBPM = 30;
-            if (tempBPM > 300) tempBPM = 300;
+            // Hold the button while turning for tenths
+            tempBPM = stepBPM(tempBPM, delta, buttonActive);
+            if (buttonActive) buttonTurned = true;
         } else if (currentState == STATE_PRESET_SELECT) {
             if (slState == SL_EDITING_ID) {
                 tempSetlistID += delta;
@@ -714,86 +735,73 @@ void loop() {
             if (a4Reference > 480) a4Reference = 480;
             audio.startTone(a4Reference);
             tuner.setA4Reference(a4Reference);
+        } else if (currentState == STATE_TUNER) {
+            // Cycle the tuner mode
+            int mode = (tunerMode + delta) % TUNER_MODE_COUNT;
+            if (mode < 0) mode += TUNER_MODE_COUNT;
+            setTunerMode(mode);
+            saveSettings();
         }
         lastEncoderValue = newEncVal;
     }
     
     // Tap Tempo Analysis
+    // Onsets are detected per sample in the mic capture task; here we only
+    // consume them, so tap timing no longer depends on the frame rate.
     if (currentState == STATE_TAP_TEMPO) {
-        float lvl = tuner.readLevel();
-        tapInputLevel = (lvl / 15000000.0f); 
-        
-        // Calculate Thresholds (Dynamic based on Sensitivity)
-        tapBeatThreshold = 5000000.0f + (1.0f - tapSensitivity) * 10000000.0f;
-        tapAccentThreshold = tapBeatThreshold * 1.5f; // Accent must be 50% louder
-        
-        if (!tapIsPeakFinding) {
-            if (lvl > tapBeatThreshold) {
-                 if (now - lastTapTime > 120) { // Debounce
-                     tapIsPeakFinding = true;
-                     tapCurrentPeak = lvl;
-                     tapPeakStartTime = now;
+        tapDetector.setSensitivity(tapSensitivity);
+        tapInputLevel = tapDetector.getLevel() * 0.4f; // Heart is full size at the threshold
+
+        TapOnset onset;
+        while (tapDetector.poll(onset)) {
+            lastActivityTime = now;
+            bool isAccent = onset.accent;
+
+            // Acoustic Feedback
+            audio.playClick(isAccent, false);
+
+            // Check Timeout (Reset if pause too long)
+            if (tapCount == 0 || (onset.us - lastTapUs) > (int64_t)TAP_TIMEOUT * 1000) {
+                 tapCount = 0;
+                 tapTempo.reset();
+                 tapMeter.reset();
+                 tapHistoryCount = 0;
+                 tapGrouping[0] = '\0';
+            }
+            tapCount++;
+
+            // BPM Update (sliding window; skips doubled/missed taps and follows tempo changes)
+            if (tapTempo.addOnset(onset.us)) {
+                 float b = roundf(tapTempo.getBpm() * 10.0f) / 10.0f; // 0.1 BPM resolution
+                 if (b >= 30 && b <= 300) {
+                     metronome.bpm = b;
+                     encoder.setCount((long)metronome.bpm * 2);
                  }
             }
-        } else {
-            // 1. Track Peak during window
-            if (lvl > tapCurrentPeak) tapCurrentPeak = lvl;
             
-            // 2. End of Peak Window (50ms)
-            if (now - tapPeakStartTime > 50) {
-                tapIsPeakFinding = false;
-                lastActivityTime = now;
-                
-                // Analyze
-                bool isAccent = (tapCurrentPeak > tapAccentThreshold);
-
-                // Acoustic Feedback
-                audio.playClick(isAccent, false);
-
-                // Check Timeout (Reset if pause too long)
-                // Use tapPeakStartTime as the event time
-                if ((tapPeakStartTime - lastTapTime) > TAP_TIMEOUT) {
-                     tapCount = 1;
-                     tapIntervalAccumulator = 0;
-                     tapHistoryCount = 0;
-                } else {
-                     tapCount++;
-                     unsigned long interval = tapPeakStartTime - lastTapTime;
-                     
-                     // Filter blips
-                     if (tapCount > 1) {
-                        tapIntervalAccumulator += interval;
-                     
-                        // BPM Update
-                        if (tapCount >= 2) {
-                            float avg = (float)tapIntervalAccumulator / (float)(tapCount - 1);
-                            if (avg > 100) { // Prevent div/0 or huge bpm
-                                int b = (int)(60000.0f / avg);
-                                if (b >= 30 && b <= 300) {
-                                    metronome.bpm = b;
-                                    encoder.setCount(metronome.bpm * 2);
-                                }
-                            }
-                        }
-                     }
-                }
-                
-                // Store in History
-                if (tapHistoryCount < MAX_TAP_HISTORY) {
-                     TapEvent evt;
-                     evt.time = tapPeakStartTime;
-                     evt.peakLevel = tapCurrentPeak;
-                     evt.isAccent = isAccent;
-                     tapHistory[tapHistoryCount] = evt;
-                     tapHistoryCount++;
-                }
-
-                // Call Pattern Recognition
-                analyzeTapRhythm();
+            // Store in History (oldest entry is overwritten)
+            TapEvent evt;
+            evt.timeUs = onset.us;
+            evt.peakLevel = onset.peak;
+            evt.isAccent = isAccent;
+            tapHistory[tapHistoryHead] = evt;
+            tapHistoryHead = (tapHistoryHead + 1) % MAX_TAP_HISTORY;
+            if (tapHistoryCount < MAX_TAP_HISTORY) tapHistoryCount++;
+
+            // Call Pattern Recognition
+            analyzeTapRhythm();
+
+            // Update timestamp
+            lastTapUs = onset.us;
+        }
+    }
 
-                // Update timestamp
-                lastTapTime = tapPeakStartTime;
-            }
+    // Latency calibration: chirps are played and located in the capture
+    if (currentState == STATE_CALIBRATE) {
+        if (calibrator.getState() == CALIB_RUNNING) lastActivityTime = now;
+        if (calibrator.update()) {
+            setLoopbackLatency(calibrator.getLatencyUs());
+            saveSettings();
         }
     }
 
@@ -887,31 +895,39 @@ void loop() {
         case STATE_QUICK_MENU:
             drawQuickMenuScreen();
             break;
+        case STATE_CALIBRATE:
+            drawCalibrateScreen();
+            break;
         case STATE_TUNER:
              if (isTunerToneOn) {
                  drawTunerScreen(a4Reference, "A4", 0);
              } else {
                  float f = tuner.getFrequency();
-                 int cents = 0;
-                 String n = tuner.getNote(f, cents);
-                 drawTunerScreen(f, n, cents); 
+                 StrobeReading strobe;
+                 StrumResult strum;
+                 if (tuner.getStrobe(strobe)) {
+                     drawStrobeScreen(strobe);
+                 } else if (tuner.getStrum() >= 0) {
+                     strum.count = 0;
+                     tuner.getStrumResult(strum);
+                     drawStrumScreen(strum);
+                 } else {
+                     int cents = 0;
+                     String n = tuner.getNote(f, cents);
+                     drawTunerScreen(f, n, cents);
+                 }
              }
             break;
     }
     u8g2.sendBuffer();
 
-    // Haptic/LED Off Timer
-    if (feedbackOffAt && now > feedbackOffAt) {
-        // Haptic Off
-        ledc_set_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)HAPTIC_PWM_CH, 0);
-        ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t)HAPTIC_PWM_CH);
-        
-        // LED Off
-        pixels.setPixelColor(0, 0);
-        pixels.show();
-        
-        feedbackOffAt = 0;
+#ifdef AUDIO_BENCHMARK
+    static unsigned long lastBenchPrint = 0;
+    if (now - lastBenchPrint > 2000) {
+        lastBenchPrint = now;
+        Serial.printf("Audio render: %u cycles/chunk\n", audio.getRenderCycles());
     }
+#endif
 
     // 3. Auto Off
     if (!metronome.isPlaying && currentState != STATE_TUNER && currentState != STATE_TAP_TEMPO && (now - lastActivityTime > AUTO_OFF_MS)) {
@@ -935,7 +951,16 @@ void drawMetronomeScreen() {
          // Maybe just gray text effect (checkered)? No, 1-bit.
     }
     
-    u8g2.print(metronome.bpm);
+    if (metronome.bpm != floorf(metronome.bpm)) {
+        // Fractional tempo: smaller digits so "97.5" still fits next to "BPM"
+        char bpmBuf[8];
+        formatBPM(bpmBuf, sizeof(bpmBuf), metronome.bpm);
+        u8g2.setFont(u8g2_font_logisoso32_tf);
+        u8g2.setCursor(8, 56);
+        u8g2.print(bpmBuf);
+    } else {
+        u8g2.print((int)metronome.bpm);
+    }
     u8g2.setDrawColor(1); // Restore
     
     u8g2.setFont(u8g2_font_profont12_mf);
@@ -1011,20 +1036,32 @@ void drawMenuScreen() {
     
     int startY = 30;
     int h = 14;
+
+    // Scroll so the selection stays inside the visible rows
+    int first = menuSelection - (MENU_VISIBLE_ROWS - 1);
+    if (first < 0) first = 0;
     
-    for (int i = 0; i < menuCount; i++) {
+    for (int i = first; i < menuCount && i < first + MENU_VISIBLE_ROWS; i++) {
+        int y = startY + (i - first) * h;
         if (i == menuSelection) {
-            u8g2.drawBox(0, startY + i*h - 9, 128, 11);
+            u8g2.drawBox(0, y - 9, 128, 11);
             u8g2.setDrawColor(0);
         } else {
             u8g2.setDrawColor(1);
         }
         
-        u8g2.setCursor(4, startY + i*h);
+        u8g2.setCursor(4, y);
         
         if (i == 0) {
              u8g2.print("Metric: ");
              u8g2.print(timeSignatures[metronome.timeSigIdx].label);
+        } else if (i == 8) {
+             u8g2.print("Audio: ");
+             u8g2.print(kAudioProfiles[audio.getProfile()].name);
+        } else if (i == 9) {
+             char buf[24];
+             snprintf(buf, sizeof(buf), "Calibrate: %.1fms", loopbackLatencyUs / 1000.0f);
+             u8g2.print(buf);
         } else {
              u8g2.print(menuItems[i]);
         }
@@ -1093,6 +1130,9 @@ void drawTunerScreen(float freq, String note, int cents) {
         u8g2.drawStr(20, 60, a4buf);
         return; 
     }
+    char engBuf[12];
+    sprintf(engBuf, "[%s]", tuner.isStrobe() ? "STROBE" : tuner.getEngineName());
+    u8g2.drawStr(128 - u8g2.getStrWidth(engBuf), 10, engBuf);
 
     if (freq < 20) {
         u8g2.drawStr(40, 60, "Listening...");
@@ -1124,25 +1164,101 @@ void drawTunerScreen(float freq, String note, int cents) {
     else u8g2.drawStr(50, 90, "* OK *");
 }
 
+void drawStrobeScreen(const StrobeReading& r) {
+    u8g2.setFont(u8g2_font_profont12_mf);
+    u8g2.drawStr(0, 10, "--- TUNER ---");
+    u8g2.drawStr(128 - u8g2.getStrWidth("[STROBE]"), 10, "[STROBE]");
+    u8g2.drawLine(0, 12, 128, 12);
+
+    // Note Name
+    int c = 0;
+    String note = tuner.getNote(r.targetHz, c);
+    u8g2.setFont(u8g2_font_logisoso32_tf);
+    int w = u8g2.getStrWidth(note.c_str());
+    u8g2.drawStr((128 - w) / 2, 52, note.c_str());
+
+    // Deviation to 0.1 cent
+    u8g2.setFont(u8g2_font_profont12_mf);
+    char buf[20];
+    sprintf(buf, "%+.1f cents", r.cents);
+    u8g2.drawStr((128 - u8g2.getStrWidth(buf)) / 2, 70, buf);
+
+    // Strobe bands, one row per harmonic: they stand still when in tune
+    // and drift right when sharp, left when flat (row n moves n times faster)
+    const int period = 16;
+    for (int row = 0; row < 3; row++) {
+        float turns = r.phase * (row + 1);
+        int offset = (int)((turns - floorf(turns)) * period);
+        int y = 80 + row * 14;
+        for (int x = offset - period; x < 128; x += period) {
+            int x0 = x < 0 ? 0 : x;
+            int x1 = x + period / 2 > 128 ? 128 : x + period / 2;
+            if (x1 > x0) u8g2.drawBox(x0, y, x1 - x0, 10);
+        }
+    }
+}
+
+void drawStrumScreen(const StrumResult& r) {
+    u8g2.setFont(u8g2_font_profont12_mf);
+    u8g2.drawStr(0, 10, "--- TUNER ---");
+    char label[12];
+    sprintf(label, "[%s]", StrumAnalyzer::instrumentName((StrumInstrument)tuner.getStrum()));
+    u8g2.drawStr(128 - u8g2.getStrWidth(label), 10, label);
+    u8g2.drawLine(0, 12, 128, 12);
+
+    if (r.count == 0) {
+        u8g2.drawStr(34, 60, "Strum all");
+        u8g2.drawStr(31, 74, "open strings");
+        return;
+    }
+
+    // One row per string, highest string on top like the tab
+    const int rowH = 18;
+    for (int i = 0; i < r.count; i++) {
+        const StrumString& s = r.strings[r.count - 1 - i];
+        int y = 16 + i * rowH;
+        int c = 0;
+        String note = tuner.getNote(tuner.getA4Reference() * powf(2.0f, (s.note - 69) / 12.0f), c);
+        u8g2.drawStr(0, y + 11, note.c_str());
+
+        u8g2.drawFrame(22, y + 3, 70, 8);
+        u8g2.drawLine(57, y + 1, 57, y + 12);
+        if (s.level == 0) {
+            u8g2.drawStr(100, y + 11, "--");
+            continue;
+        }
+        float cents = s.centsX10 / 10.0f;
+        int x = 57 + (int)(cents * 0.7f);
+        if (x < 24) x = 24;
+        if (x > 90) x = 90;
+        u8g2.drawBox(x - 1, y + 3, 3, 8);
+
+        char buf[8];
+        if (fabsf(cents) < 1.0f) sprintf(buf, "OK");
+        else sprintf(buf, "%+d", (int)lroundf(cents));
+        u8g2.drawStr(96, y + 11, buf);
+    }
+}
+
 void drawBPMScreen() {
     u8g2.setFont(u8g2_font_profont12_mf);
     u8g2.drawStr(0, 12, "--- SET SPEED ---");
     
-    // Big number
-    u8g2.setFont(u8g2_font_logisoso42_tn);
+    // Big number, always with the tenths digit being edited
+    u8g2.setFont(u8g2_font_logisoso32_tf);
     char buf[8];
-    sprintf(buf, "%d", tempBPM);
+    snprintf(buf, sizeof(buf), "%.1f", tempBPM);
     int w = u8g2.getStrWidth(buf);
-    u8g2.setCursor((128 - w) / 2, 70); 
-    u8g2.print(tempBPM);
+    u8g2.drawStr((128 - w) / 2, 70, buf);
     
     u8g2.setFont(u8g2_font_profont12_mf);
     u8g2.drawStr(54, 90, "BPM");
     
     // Arrows
-    u8g2.drawTriangle(10, 50, 25, 40, 25, 60); // Left
-    u8g2.drawTriangle(118, 50, 103, 40, 103, 60); // Right
-    u8g2.drawStr(25, 110, "Click to Set");
+    u8g2.drawTriangle(4, 54, 16, 44, 16, 64); // Left
+    u8g2.drawTriangle(124, 54, 112, 44, 112, 64); // Right
+    u8g2.drawStr(10, 104, "Hold+Turn: 0.1 BPM");
+    u8g2.drawStr(25, 118, "Click to Set");
 }
 
 void drawTapScreen() {
@@ -1186,8 +1302,10 @@ void drawTapScreen() {
     sprintf(buf, "Sens: %d%%", (int)(tapSensitivity * 100));
     u8g2.drawStr(5, 120, buf);
 
-    if (tapCount > 1) {
-        sprintf(buf, "BPM: %d", metronome.bpm);
+    if (tapTempo.hasEstimate()) {
+        char bpmBuf[8];
+        formatBPM(bpmBuf, sizeof(bpmBuf), metronome.bpm);
+        sprintf(buf, "BPM: %s", bpmBuf);
         u8g2.drawStr(65, 120, buf);
     } else {
          u8g2.drawStr(65, 120, "TAP NOW!");
@@ -1196,11 +1314,15 @@ void drawTapScreen() {
     // Display Detected Metric and Accent Status
     u8g2.setCursor(95, 30);
     u8g2.print(timeSignatures[metronome.timeSigIdx].label);
+    if (tapGrouping[0]) {
+        u8g2.setCursor(95, 60);
+        u8g2.print(tapGrouping);
+    }
     
     if (tapHistoryCount > 0) {
-        if (millis() - tapHistory[tapHistoryCount-1].time < 400) {
+        if (esp_timer_get_time() - tapAt(tapHistoryCount-1).timeUs < 400000) {
             u8g2.setCursor(95, 45);
-            if (tapHistory[tapHistoryCount-1].isAccent) {
+            if (tapAt(tapHistoryCount-1).isAccent) {
                 u8g2.print("ACC!");
             } else {
                 u8g2.print("Tap");
@@ -1209,6 +1331,22 @@ void drawTapScreen() {
     }
 }
 
+// Whole tempos print as "120", fractional ones as "97.5"
+void formatBPM(char* buf, size_t len, float bpm) {
+    if (bpm == floorf(bpm)) snprintf(buf, len, "%d", (int)bpm);
+    else snprintf(buf, len, "%.1f", bpm);
+}
+
+// One encoder move: whole BPM, or tenths while fine; kept on the 0.1 grid
+// so repeated fine steps don't drift away from round tempos
+float stepBPM(float bpm, long delta, bool fine) {
+    bpm += delta * (fine ? BPM_FINE_STEP : 1.0f);
+    bpm = roundf(bpm * 10.0f) / 10.0f;
+    if (bpm < 30) bpm = 30;
+    if (bpm > 300) bpm = 300;
+    return bpm;
+}
+
 // --- Helper Functions to read setlist from Prefs for display ---
 int getPresetSetlistID(int slot) {
     char keySL[16]; sprintf(keySL, "p%d_slist", slot);
@@ -1251,13 +1389,15 @@ void drawPresetScreen() {
         u8g2.drawStr(40, 70, "(Empty)");
     } else {
         // Read values (or what WILL be overwritten)
-        int pBpm;
+        float pBpm;
         if (presetMode == PRESET_SAVE && !prefs.isKey(key)) {
              u8g2.drawStr(45, 65, "(New)");
              u8g2.setFont(u8g2_font_profont12_mf);
         } else {
              // Existing data
-             pBpm = prefs.getInt(key, 120);
+             pBpm = (float)prefs.getInt(key, 120);
+             char keyF[16]; sprintf(keyF, "p%d_bpmf", presetSlot);
+             pBpm = prefs.getFloat(keyF, pBpm);
              char keyTs[16]; sprintf(keyTs, "p%d_ts_idx", presetSlot);
              int tsIdx = prefs.getInt(keyTs, 3); // Default 4/4
              if(tsIdx < 0 || tsIdx >= NUM_TIME_SIGS) tsIdx = 3;
@@ -1265,7 +1405,7 @@ void drawPresetScreen() {
              // Display Logic: "4/4 @ 120"
              u8g2.setFont(u8g2_font_logisoso24_tn);
              char infoBuf[16];
-             sprintf(infoBuf, "%d", pBpm);
+             formatBPM(infoBuf, sizeof(infoBuf), pBpm);
              u8g2.drawStr(10, 80, infoBuf);
              
              u8g2.setFont(u8g2_font_profont12_mf);
@@ -1298,12 +1438,11 @@ void enterDeepSleep() {
     delay(500);
     
     // LEDs Off
-    pixels.clear();
-    pixels.show();
+    ledRing.clear();
     
     // Stop Audio/Tuner
     audio.stopTone();
-    tuner.stop();
+    mic.pause();
     
     delay(100);
     u8g2.setPowerSave(1); // Screen off
@@ -1316,16 +1455,29 @@ void enterDeepSleep() {
     esp_deep_sleep_start();
 }
 
+void setTunerMode(int mode) {
+    if (mode < 0 || mode >= TUNER_MODE_COUNT) mode = PITCH_ENGINE_FFT;
+    tunerMode = mode;
+    // Strobe mode relies on YIN to find the note
+    tuner.setEngine(mode < PITCH_ENGINE_COUNT ? (PitchEngineId)mode : PITCH_ENGINE_YIN);
+    tuner.setStrobe(mode == TUNER_MODE_STROBE);
+    tuner.setStrum(mode >= TUNER_MODE_STRUM ? mode - TUNER_MODE_STRUM : -1);
+}
+
 void saveSettings() {
-    prefs.putInt("bpm", metronome.bpm);
+    prefs.putInt("bpm", (int)roundf(metronome.bpm)); // Legacy key (whole BPM)
+    prefs.putFloat("bpmf", metronome.bpm);
     prefs.putInt("ts_idx", metronome.timeSigIdx); // Changed from ts to ts_idx
     prefs.putInt("vol", audio.getVolume());
     prefs.putFloat("a4", a4Reference);
     prefs.putBool("haptic", hapticEnabled);
+    prefs.putInt("aprof", audio.getProfile());
+    prefs.putInt("tmode", tunerMode);
+    prefs.putInt("lat_us", loopbackLatencyUs);
 }
 
 void loadSettings() {
-    metronome.bpm = prefs.getInt("bpm", 120);
+    metronome.bpm = prefs.getFloat("bpmf", (float)prefs.getInt("bpm", 120));
     // Migration logic for old ts
     if (prefs.isKey("ts_idx")) {
         metronome.timeSigIdx = prefs.getInt("ts_idx", 3); // 3 = 4/4
@@ -1342,15 +1494,28 @@ void loadSettings() {
     int vol = prefs.getInt("vol", 50);
     a4Reference = prefs.getFloat("a4", 440.0f);
     hapticEnabled = prefs.getBool("haptic", true);
+    int profile = prefs.getInt("aprof", AUDIO_PROFILE_BALANCED);
+    if (profile >= 0 && profile < AUDIO_PROFILE_COUNT) audio.setProfile((AudioProfileId)profile);
     if (vol < 0) vol = 0; if (vol > 100) vol = 100;
     audio.setVolume(vol);
     tuner.setA4Reference(a4Reference);
+    setTunerMode(prefs.getInt("tmode", PITCH_ENGINE_FFT));
+    setLoopbackLatency(prefs.getInt("lat_us", TAP_ACOUSTIC_LATENCY_US));
+}
+
+// Calibrated speaker -> mic delay: aligns haptics/LED with the sound and
+// tap timestamps with the clicks (see TapOnset::us)
+void setLoopbackLatency(int32_t us) {
+    loopbackLatencyUs = us;
+    tapDetector.setAcousticLatencyUs(us);
 }
 
 void savePreset(int slot) {
     char key[16];
     sprintf(key, "p%d_bpm", slot);
-    prefs.putInt(key, metronome.bpm);
+    prefs.putInt(key, (int)roundf(metronome.bpm));
+    sprintf(key, "p%d_bpmf", slot);
+    prefs.putFloat(key, metronome.bpm);
     sprintf(key, "p%d_ts_idx", slot);
     prefs.putInt(key, metronome.timeSigIdx);
     sprintf(key, "p%d_vol", slot);
@@ -1362,7 +1527,9 @@ void savePreset(int slot) {
 void loadPreset(int slot) {
     char key[16];
     sprintf(key, "p%d_bpm", slot);
-    metronome.bpm = prefs.getInt(key, metronome.bpm);
+    float pBpm = (float)prefs.getInt(key, (int)roundf(metronome.bpm));
+    sprintf(key, "p%d_bpmf", slot);
+    metronome.bpm = prefs.getFloat(key, pBpm);
     sprintf(key, "p%d_ts_idx", slot);
     // Presets might need migration too if kept long term, but assuming fresh oroverwrite
     // Default to current sig if fail
@@ -1374,7 +1541,7 @@ void loadPreset(int slot) {
     a4Reference = prefs.getFloat(key, a4Reference);
     tuner.setA4Reference(a4Reference);
     audio.setVolume(vol);
-    encoder.setCount(metronome.bpm * 2);
+    encoder.setCount((long)metronome.bpm * 2);
     saveSettings();
 }
 
@@ -1433,4 +1600,36 @@ void drawQuickMenuScreen() {
     u8g2.drawStr(25, 105, "Click: Edit/Save");
 }
 
+void drawCalibrateScreen() {
+    u8g2.setFont(u8g2_font_profont12_mf);
+    u8g2.drawStr(0, 12, "-- CALIBRATE --");
+    u8g2.drawLine(0, 14, 128, 14);
 
+    char buf[24];
+    CalibrationState state = calibrator.getState();
+    if (state == CALIB_RUNNING) {
+        u8g2.drawStr(10, 40, "Keep quiet...");
+        snprintf(buf, sizeof(buf), "Chirp %d/%d", calibrator.getBurst() + 1, CALIB_BURSTS);
+        u8g2.drawStr(10, 60, buf);
+        // Progress bar
+        u8g2.drawFrame(10, 72, 108, 10);
+        u8g2.drawBox(10, 72, 108 * calibrator.getBurst() / CALIB_BURSTS, 10);
+    } else if (state == CALIB_DONE) {
+        u8g2.setFont(u8g2_font_logisoso32_tf);
+        snprintf(buf, sizeof(buf), "%.1f", calibrator.getLatencyUs() / 1000.0f);
+        int w = u8g2.getStrWidth(buf);
+        u8g2.setCursor((128 - w) / 2, 70);
+        u8g2.print(buf);
+        u8g2.setFont(u8g2_font_profont12_mf);
+        snprintf(buf, sizeof(buf), "ms  (%d/%d ok)", calibrator.getGoodBursts(), CALIB_BURSTS);
+        u8g2.drawStr(24, 90, buf);
+        u8g2.drawStr(40, 110, "Saved");
+    } else {
+        u8g2.drawStr(10, 40, "Failed:");
+        u8g2.drawStr(10, 56, calibrator.getError());
+        snprintf(buf, sizeof(buf), "Kept %.1f ms", loopbackLatencyUs / 1000.0f);
+        u8g2.drawStr(10, 80, buf);
+        u8g2.setFont(u8g2_font_profont10_mr);
+        u8g2.drawStr(10, 105, "Raise volume, retry");
+    }
+}